@@ -0,0 +1,496 @@
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <new>
+#include "./../../include/SimpleJson.hpp"
+
+//----------------------------- ALLOCATION COUNTING ------------------------------//
+
+//atomic because JsonFileLoader's threads allocate too
+static atomic<size_t> g_allocations {0};
+static atomic<size_t> g_allocatedBytes {0};
+
+void* operator new(size_t size) {
+	g_allocations.fetch_add(1, memory_order_relaxed);
+	g_allocatedBytes.fetch_add(size, memory_order_relaxed);
+	if (void* pMemory = malloc(size ? size : 1)) return pMemory;
+	throw bad_alloc();
+}
+
+//kept out of line: once inlined, gcc sees free() paired with the builtin operator new and warns about a mismatch
+[[gnu::noinline]] void operator delete(void* pMemory) noexcept {
+	free(pMemory);
+}
+
+[[gnu::noinline]] void operator delete(void* pMemory, size_t) noexcept {
+	free(pMemory);
+}
+
+//std::pmr::new_delete_resource, which documents use by default, allocates through the aligned overloads
+void* operator new(size_t size, align_val_t alignment) {
+	g_allocations.fetch_add(1, memory_order_relaxed);
+	g_allocatedBytes.fetch_add(size, memory_order_relaxed);
+	size_t align = static_cast<size_t>(alignment);
+	if (void* pMemory = aligned_alloc(align, (max<size_t>(size, 1) + align - 1) / align * align)) return pMemory;
+	throw bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void* pMemory, align_val_t) noexcept {
+	free(pMemory);
+}
+
+[[gnu::noinline]] void operator delete(void* pMemory, size_t, align_val_t) noexcept {
+	free(pMemory);
+}
+
+/**
+ * @class AllocationCounter
+ * records the allocations made between construction and report(), averaged per benchmark iteration
+ */
+class AllocationCounter {
+private:
+	size_t m_allocations = g_allocations.load(memory_order_relaxed);
+	size_t m_allocatedBytes = g_allocatedBytes.load(memory_order_relaxed);
+public:
+	void report(benchmark::State& state) {
+		state.counters["allocs"] = benchmark::Counter(g_allocations.load(memory_order_relaxed) - m_allocations, benchmark::Counter::kAvgIterations);
+		state.counters["alloc_bytes"] = benchmark::Counter(g_allocatedBytes.load(memory_order_relaxed) - m_allocatedBytes, benchmark::Counter::kAvgIterations);
+	}
+};
+
+//----------------------------- CORPORA ------------------------------//
+
+enum Corpus {
+	DEEP,
+	WIDE,
+	RECORDS,
+	NUMBERS,
+	STRINGS,
+	ESCAPED
+};
+
+// nested objects: {"level": {"level": ... {"value": 1} ... }}
+string generateDeep(size_t bytes) {
+	size_t depth = max<size_t>(1, bytes / 13);
+	string output;
+	for (size_t i = 0; i < depth; i++) output.append("{\"level\": ");
+	output.append("{\"value\": 1}");
+	output.append(depth, '}');
+	return output;
+}
+
+// one object with many keys: {"key0": "value0", "key1": 1, ...}
+string generateWide(size_t bytes) {
+	string output = "{";
+	for (size_t i = 0; output.size() < bytes; i++) {
+		if (i) output.append(", ");
+		output.append("\"key" + to_string(i) + "\": ");
+		output.append(i % 2 ? to_string(i) : "\"value" + to_string(i) + "\"");
+	}
+	output.append("}");
+	return output;
+}
+
+// long array of small records, similar to examples/large-valid.json
+string generateRecords(size_t bytes) {
+	string output = "[";
+	for (size_t i = 0; output.size() < bytes; i++) {
+		if (i) output.append(", ");
+		output.append("{\"id\": " + to_string(i) + ", \"name\": \"person" + to_string(i) + "\", \"remote\": " + (i % 3 ? "true" : "false") + ", \"skills\": [\"frontend\", \"backend\"]}");
+	}
+	output.append("]");
+	return output;
+}
+
+// long array of floating point numbers
+string generateNumbers(size_t bytes) {
+	string output = "[";
+	for (size_t i = 0; output.size() < bytes; i++) {
+		if (i) output.append(", ");
+		output.append(to_string(i * 0.37 - 1000.0));
+	}
+	output.append("]");
+	return output;
+}
+
+// long array of long strings
+string generateStrings(size_t bytes) {
+	string output = "[";
+	for (size_t i = 0; output.size() < bytes; i++) {
+		if (i) output.append(", ");
+		output.append("\"lorem ipsum dolor sit amet, consectetur adipiscing elit " + to_string(i) + "\"");
+	}
+	output.append("]");
+	return output;
+}
+
+// long array of log lines with the occasional escaped quote, newline and unicode character
+string generateEscaped(size_t bytes) {
+	string output = "[";
+	for (size_t i = 0; output.size() < bytes; i++) {
+		if (i) output.append(", ");
+		output.append("\"GET /api/items?id=" + to_string(i) + " returned \\\"ok\\\" in 12ms from caf\\u00e9-server\\n\"");
+	}
+	output.append("]");
+	return output;
+}
+
+// corpora are generated once per (type, size) and shared between benchmarks
+const string& getCorpus(Corpus corpus, size_t bytes) {
+	static map<pair<Corpus, size_t>, string> s_corpora;
+	pair<Corpus, size_t> key(corpus, bytes);
+	auto found = s_corpora.find(key);
+	if (found != s_corpora.end()) return found->second;
+	switch (corpus) {
+		case DEEP:
+			return s_corpora[key] = generateDeep(bytes);
+		case WIDE:
+			return s_corpora[key] = generateWide(bytes);
+		case RECORDS:
+			return s_corpora[key] = generateRecords(bytes);
+		case NUMBERS:
+			return s_corpora[key] = generateNumbers(bytes);
+		case ESCAPED:
+			return s_corpora[key] = generateEscaped(bytes);
+		default:
+			return s_corpora[key] = generateStrings(bytes);
+	}
+}
+
+// largest corpus size, 64 KB by default - set SIMPLEJSON_BENCH_MAX_BYTES (up to 1 GB) for the large runs
+int64_t maxCorpusBytes() {
+	const char* pMax = getenv("SIMPLEJSON_BENCH_MAX_BYTES");
+	int64_t maxBytes = pMax ? atoll(pMax) : 1 << 16;
+	return min<int64_t>(max<int64_t>(maxBytes, 1 << 10), int64_t(1) << 30);
+}
+
+void corpusSizes(benchmark::internal::Benchmark* pBenchmark) {
+	pBenchmark->RangeMultiplier(16)->Range(1 << 10, maxCorpusBytes())->Unit(benchmark::kMicrosecond);
+}
+
+//----------------------------- BENCHMARKS ------------------------------//
+
+void BM_Parse(benchmark::State& state, Corpus corpus) {
+	const string& input = getCorpus(corpus, state.range(0));
+	AllocationCounter counter;
+	for (auto _ : state) {
+		SimpleJson json(input);
+		benchmark::DoNotOptimize(json);
+	}
+	counter.report(state);
+	state.SetBytesProcessed(state.iterations() * input.size());
+	//bytes held by the parsed document, to track the size of the element tree
+	state.counters["doc_bytes"] = SimpleJson(input).memoryUsage().total();
+}
+
+// parse with a key pool, so repeated keys are stored once
+void BM_ParseInternedKeys(benchmark::State& state, Corpus corpus) {
+	const string& input = getCorpus(corpus, state.range(0));
+	JsonOptions options;
+	options.internKeys = true;
+	AllocationCounter counter;
+	for (auto _ : state) {
+		SimpleJson json(input, options);
+		benchmark::DoNotOptimize(json);
+	}
+	counter.report(state);
+	state.SetBytesProcessed(state.iterations() * input.size());
+}
+
+// parse into a monotonic buffer released after each document, to compare against BM_Parse
+void BM_ParseMonotonic(benchmark::State& state, Corpus corpus) {
+	const string& input = getCorpus(corpus, state.range(0));
+	vector<char> buffer(input.size() * 16);
+	pmr::monotonic_buffer_resource resource(buffer.data(), buffer.size());
+	JsonOptions options;
+	options.memoryResource = &resource;
+	AllocationCounter counter;
+	for (auto _ : state) {
+		{
+			SimpleJson json(input, options);
+			benchmark::DoNotOptimize(json);
+		}
+		resource.release();
+	}
+	counter.report(state);
+	state.SetBytesProcessed(state.iterations() * input.size());
+}
+
+// parse with utf-8 validation, to compare against BM_Parse
+void BM_ParseValidateUtf8(benchmark::State& state, Corpus corpus) {
+	const string& input = getCorpus(corpus, state.range(0));
+	JsonOptions options;
+	options.validateUtf8 = true;
+	AllocationCounter counter;
+	for (auto _ : state) {
+		SimpleJson json(input, options);
+		benchmark::DoNotOptimize(json);
+	}
+	counter.report(state);
+	state.SetBytesProcessed(state.iterations() * input.size());
+}
+
+// parse with subtree hashing, to compare against BM_Parse
+void BM_ParseHashSubtrees(benchmark::State& state, Corpus corpus) {
+	const string& input = getCorpus(corpus, state.range(0));
+	JsonOptions options;
+	options.hashSubtrees = true;
+	for (auto _ : state) {
+		SimpleJson json(input, options);
+		benchmark::DoNotOptimize(json);
+	}
+	state.SetBytesProcessed(state.iterations() * input.size());
+}
+
+// compare two copies of a document, by serializing both or by subtree hash
+void BM_Equals(benchmark::State& state, bool hashSubtrees) {
+	const string& input = getCorpus(RECORDS, state.range(0));
+	JsonOptions options;
+	options.hashSubtrees = hashSubtrees;
+	SimpleJson first(input, options);
+	SimpleJson second(input, options);
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(first.equals(second));
+	}
+}
+
+// parse into one recycled document, as a request loop would
+void BM_Reparse(benchmark::State& state, Corpus corpus) {
+	const string& input = getCorpus(corpus, state.range(0));
+	SimpleJson json(input);
+	json.reparse(input);
+	AllocationCounter counter;
+	for (auto _ : state) {
+		json.reparse(input);
+	}
+	counter.report(state);
+	state.SetBytesProcessed(state.iterations() * input.size());
+}
+
+void BM_Serialize(benchmark::State& state, Corpus corpus) {
+	const string& input = getCorpus(corpus, state.range(0));
+	SimpleJson json(input);
+	AllocationCounter counter;
+	for (auto _ : state) {
+		string output = json.serialize();
+		benchmark::DoNotOptimize(output);
+	}
+	counter.report(state);
+	state.SetBytesProcessed(state.iterations() * input.size());
+}
+
+void BM_SerializeCanonical(benchmark::State& state, Corpus corpus) {
+	const string& input = getCorpus(corpus, state.range(0));
+	SimpleJson json(input);
+	AllocationCounter counter;
+	for (auto _ : state) {
+		string output = json.serializeCanonical();
+		benchmark::DoNotOptimize(output);
+	}
+	counter.report(state);
+	state.SetBytesProcessed(state.iterations() * input.size());
+}
+
+// look up the last key of a wide object, the worst case for the linear member search
+void BM_GetByKey(benchmark::State& state) {
+	const string& input = getCorpus(WIDE, state.range(0));
+	SimpleJson json(input);
+	size_t lastKey = 0;
+	while (input.find("\"key" + to_string(lastKey + 1) + "\"") != string::npos) lastKey++;
+	string key = "key" + to_string(lastKey);
+	AllocationCounter counter;
+	for (auto _ : state) {
+		SimpleJson value = json.get(key);
+		benchmark::DoNotOptimize(value);
+	}
+	counter.report(state);
+}
+
+// look up the last item of a long array
+void BM_GetByIndex(benchmark::State& state) {
+	const string& input = getCorpus(NUMBERS, state.range(0));
+	SimpleJson json(input);
+	int lastIndex = count(input.begin(), input.end(), ',');
+	AllocationCounter counter;
+	for (auto _ : state) {
+		SimpleJson value = json.get(lastIndex);
+		benchmark::DoNotOptimize(value);
+	}
+	counter.report(state);
+}
+
+// sum every item of a long array through a view, which should not allocate
+void BM_IterateItems(benchmark::State& state) {
+	const string& input = getCorpus(NUMBERS, state.range(0));
+	SimpleJson json(input);
+	AllocationCounter counter;
+	for (auto _ : state) {
+		float total = 0;
+		for (JsonView item : json.items()) total += item.getFloat();
+		benchmark::DoNotOptimize(total);
+	}
+	counter.report(state);
+	state.SetBytesProcessed(state.iterations() * input.size());
+}
+
+// convert a parsed array of numbers into a vector in one pass
+void BM_ToVector(benchmark::State& state) {
+	const string& input = getCorpus(NUMBERS, state.range(0));
+	SimpleJson json(input);
+	AllocationCounter counter;
+	for (auto _ : state) {
+		vector<double> values = json.toVector<double>();
+		benchmark::DoNotOptimize(values);
+	}
+	counter.report(state);
+	state.SetBytesProcessed(state.iterations() * input.size());
+}
+
+// read an array of numbers straight from the text, without building an element tree
+void BM_ParseNumberArray(benchmark::State& state) {
+	const string& input = getCorpus(NUMBERS, state.range(0));
+	AllocationCounter counter;
+	for (auto _ : state) {
+		vector<double> values = JsonMapper::parse<vector<double>>(input);
+		benchmark::DoNotOptimize(values);
+	}
+	counter.report(state);
+	state.SetBytesProcessed(state.iterations() * input.size());
+}
+
+// overwrite the last key of a wide object
+void BM_Set(benchmark::State& state) {
+	const string& input = getCorpus(WIDE, state.range(0));
+	SimpleJson json(input);
+	size_t lastKey = 0;
+	while (input.find("\"key" + to_string(lastKey + 1) + "\"") != string::npos) lastKey++;
+	string key = "key" + to_string(lastKey);
+	AllocationCounter counter;
+	for (auto _ : state) {
+		json.key(key).setFloat(state.iterations());
+	}
+	counter.report(state);
+}
+
+// write records straight to a string with JsonWriter, without building a document
+void BM_Write(benchmark::State& state) {
+	size_t records = max<size_t>(state.range(0) / 64, 1);
+	string output;
+	AllocationCounter counter;
+	for (auto _ : state) {
+		output.clear();
+		JsonWriter writer(output);
+		writer.beginArray();
+		for (size_t i = 0; i < records; i++)
+			writer.beginObject().key("id").value(i).key("name").value("record name").key("score").value(i * 0.25).key("active").value(i % 2 == 0).endObject();
+		writer.endArray();
+		benchmark::DoNotOptimize(output.data());
+	}
+	counter.report(state);
+	state.SetBytesProcessed(state.iterations() * output.size());
+}
+
+void BM_FileLoad(benchmark::State& state, Corpus corpus) {
+	const string& input = getCorpus(corpus, state.range(0));
+	filesystem::path path = filesystem::temp_directory_path() / ("simplejson-bench-" + to_string(corpus) + "-" + to_string(state.range(0)) + ".json");
+	ofstream(path, ios::binary) << input;
+	AllocationCounter counter;
+	for (auto _ : state) {
+		ifstream stream(path, ios::binary);
+		SimpleJson json(stream);
+		benchmark::DoNotOptimize(json);
+	}
+	counter.report(state);
+	state.SetBytesProcessed(state.iterations() * input.size());
+	filesystem::remove(path);
+}
+
+// load a batch of files one after another, then through the pipelined loader - timed in wall clock as the loader works on other threads
+const size_t BATCH_FILES = 16;
+
+vector<filesystem::path> writeBatch(Corpus corpus, size_t bytes) {
+	vector<filesystem::path> paths;
+	for (size_t i = 0; i < BATCH_FILES; i++) {
+		paths.push_back(filesystem::temp_directory_path() / ("simplejson-batch-" + to_string(corpus) + "-" + to_string(bytes) + "-" + to_string(i) + ".json"));
+		ofstream(paths.back(), ios::binary) << getCorpus(corpus, bytes);
+	}
+	return paths;
+}
+
+void BM_BatchLoad(benchmark::State& state, Corpus corpus) {
+	vector<filesystem::path> paths = writeBatch(corpus, state.range(0));
+	for (auto _ : state) {
+		for (const filesystem::path& path : paths) {
+			ifstream stream(path, ios::binary);
+			SimpleJson json(stream);
+			benchmark::DoNotOptimize(json);
+		}
+	}
+	state.SetBytesProcessed(state.iterations() * BATCH_FILES * state.range(0));
+	for (const filesystem::path& path : paths) filesystem::remove(path);
+}
+
+void BM_BatchLoadAsync(benchmark::State& state, Corpus corpus) {
+	vector<filesystem::path> paths = writeBatch(corpus, state.range(0));
+	JsonFileLoader loader;
+	vector<future<unique_ptr<SimpleJson>>> results;
+	for (auto _ : state) {
+		for (const filesystem::path& path : paths) results.push_back(loader.load(path.string()));
+		for (future<unique_ptr<SimpleJson>>& result : results) benchmark::DoNotOptimize(result.get());
+		results.clear();
+	}
+	state.SetBytesProcessed(state.iterations() * BATCH_FILES * state.range(0));
+	for (const filesystem::path& path : paths) filesystem::remove(path);
+}
+
+BENCHMARK_CAPTURE(BM_Parse, deep, DEEP)->Apply(corpusSizes);
+BENCHMARK_CAPTURE(BM_Parse, wide, WIDE)->Apply(corpusSizes);
+BENCHMARK_CAPTURE(BM_Parse, records, RECORDS)->Apply(corpusSizes);
+BENCHMARK_CAPTURE(BM_Parse, numbers, NUMBERS)->Apply(corpusSizes);
+BENCHMARK_CAPTURE(BM_Parse, strings, STRINGS)->Apply(corpusSizes);
+BENCHMARK_CAPTURE(BM_Parse, escaped, ESCAPED)->Apply(corpusSizes);
+
+BENCHMARK_CAPTURE(BM_ParseInternedKeys, records, RECORDS)->Apply(corpusSizes);
+
+BENCHMARK_CAPTURE(BM_ParseMonotonic, records, RECORDS)->Apply(corpusSizes);
+BENCHMARK_CAPTURE(BM_ParseMonotonic, strings, STRINGS)->Apply(corpusSizes);
+
+BENCHMARK_CAPTURE(BM_ParseValidateUtf8, strings, STRINGS)->Apply(corpusSizes);
+BENCHMARK_CAPTURE(BM_ParseValidateUtf8, escaped, ESCAPED)->Apply(corpusSizes);
+
+BENCHMARK_CAPTURE(BM_ParseHashSubtrees, records, RECORDS)->Apply(corpusSizes);
+
+BENCHMARK_CAPTURE(BM_Equals, serialized, false)->Apply(corpusSizes);
+BENCHMARK_CAPTURE(BM_Equals, hashed, true)->Apply(corpusSizes);
+
+BENCHMARK_CAPTURE(BM_Reparse, records, RECORDS)->Apply(corpusSizes);
+BENCHMARK_CAPTURE(BM_Reparse, strings, STRINGS)->Apply(corpusSizes);
+
+BENCHMARK_CAPTURE(BM_Serialize, deep, DEEP)->Apply(corpusSizes);
+BENCHMARK_CAPTURE(BM_Serialize, wide, WIDE)->Apply(corpusSizes);
+BENCHMARK_CAPTURE(BM_Serialize, records, RECORDS)->Apply(corpusSizes);
+BENCHMARK_CAPTURE(BM_Serialize, numbers, NUMBERS)->Apply(corpusSizes);
+BENCHMARK_CAPTURE(BM_Serialize, strings, STRINGS)->Apply(corpusSizes);
+BENCHMARK_CAPTURE(BM_Serialize, escaped, ESCAPED)->Apply(corpusSizes);
+
+BENCHMARK_CAPTURE(BM_SerializeCanonical, wide, WIDE)->Apply(corpusSizes);
+BENCHMARK_CAPTURE(BM_SerializeCanonical, records, RECORDS)->Apply(corpusSizes);
+BENCHMARK_CAPTURE(BM_SerializeCanonical, numbers, NUMBERS)->Apply(corpusSizes);
+
+BENCHMARK(BM_GetByKey)->Apply(corpusSizes);
+BENCHMARK(BM_GetByIndex)->Apply(corpusSizes);
+BENCHMARK(BM_IterateItems)->Apply(corpusSizes);
+BENCHMARK(BM_ToVector)->Apply(corpusSizes);
+BENCHMARK(BM_ParseNumberArray)->Apply(corpusSizes);
+BENCHMARK(BM_Set)->Apply(corpusSizes);
+BENCHMARK(BM_Write)->Apply(corpusSizes);
+
+BENCHMARK_CAPTURE(BM_FileLoad, records, RECORDS)->Apply(corpusSizes);
+BENCHMARK_CAPTURE(BM_FileLoad, strings, STRINGS)->Apply(corpusSizes);
+
+BENCHMARK_CAPTURE(BM_BatchLoad, records, RECORDS)->Apply(corpusSizes)->UseRealTime();
+BENCHMARK_CAPTURE(BM_BatchLoadAsync, records, RECORDS)->Apply(corpusSizes)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -2,9 +2,891 @@
 #include <iostream>
 #include <sstream>
 #include <algorithm>
+#include <iterator>
 #include <list>
+#include <deque>
+#include <memory>
+#include <memory_resource>
+#include <unordered_map>
+#include <vector>
+#include <tuple>
+#include <utility>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <string_view>
+#include <type_traits>
+#include <charconv>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <cstring>
+#include <stdexcept>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define SIMPLEJSON_AVX2_DISPATCH	//AVX2 code is compiled with a target attribute and only run if the cpu supports it
+#endif
 using namespace std;
 
+#ifdef SIMPLEJSON_STATS
+#include <chrono>
+
+class Element;
+
+/**
+ * @class JsonStats
+ * Counters filled in by parsing, serialization, tree copies and lookups. Only compiled in when SIMPLEJSON_STATS is defined
+ * Collection is enabled per thread by creating a JsonStats::Scope
+ */
+struct JsonStats {
+	size_t bytesParsed = 0;
+	size_t bytesSerialized = 0;
+	size_t nulls = 0;
+	size_t strings = 0;
+	size_t bools = 0;
+	size_t numbers = 0;
+	size_t objects = 0;
+	size_t arrays = 0;
+	size_t maxDepth = 0;
+	size_t elementsCopied = 0;
+	size_t allocations = 0;		//allocations made by documents through their memory resource: elements, strings, indices and key pools
+	size_t allocatedBytes = 0;
+	size_t lookups = 0;
+	size_t lookupSteps = 0;
+	chrono::nanoseconds parseTime {0};
+	chrono::nanoseconds serializeTime {0};
+	chrono::nanoseconds copyTime {0};
+
+	/**
+	 * @brief average number of elements visited per lookup
+	 */
+	double averageLookupLength() const {
+		return lookups ? double(lookupSteps) / lookups : 0;
+	}
+
+	void countElement(const Element& element);
+
+	/**
+	 * @brief record an allocation made by the library
+	 */
+	void countAllocation(size_t bytes) {
+		allocations++;
+		allocatedBytes += bytes;
+	}
+
+	/**
+	 * @brief record the depth of a newly opened object or array
+	 */
+	void countDepth(size_t depth) {
+		maxDepth = max(maxDepth, depth);
+	}
+
+	/**
+	 * @brief return the stats object collecting for the current thread, or nullptr if none
+	 */
+	static JsonStats*& current() {
+		static thread_local JsonStats* s_pCurrent = nullptr;
+		return s_pCurrent;
+	}
+
+	/**
+	 * @class Scope
+	 * collect stats into the given object for all SimpleJson operations on this thread until the scope ends
+	 */
+	class Scope {
+	private:
+		JsonStats* m_pPrevious;
+	public:
+		Scope(JsonStats& stats) : m_pPrevious(current()) {
+			current() = &stats;
+		}
+
+		~Scope() {
+			current() = m_pPrevious;
+		}
+	};
+
+	/**
+	 * @class Timer
+	 * add the time spent in the enclosing block to one of the phase timers
+	 */
+	class Timer {
+	private:
+		JsonStats* m_pStats = current();
+		chrono::nanoseconds JsonStats::* m_phase;
+		chrono::steady_clock::time_point m_start;
+	public:
+		Timer(chrono::nanoseconds JsonStats::* phase) : m_phase(phase) {
+			if (m_pStats) m_start = chrono::steady_clock::now();
+		}
+
+		~Timer() {
+			if (m_pStats) m_pStats->*m_phase += chrono::steady_clock::now() - m_start;
+		}
+	};
+};
+
+#define SIMPLEJSON_STAT(statement) do { if (JsonStats* pJsonStats = JsonStats::current()) pJsonStats->statement; } while (0)
+#define SIMPLEJSON_STAT_TIMER(phase) JsonStats::Timer jsonStatsTimer(&JsonStats::phase)
+
+/**
+ * @class JsonStatsResource
+ * Memory resource placed in front of a document's own resource, so every allocation the document makes is counted in one place
+ */
+class JsonStatsResource : public pmr::memory_resource {
+private:
+	pmr::memory_resource* m_pUpstream;
+
+	void* do_allocate(size_t bytes, size_t alignment) override {
+		SIMPLEJSON_STAT(countAllocation(bytes));
+		return m_pUpstream->allocate(bytes, alignment);
+	}
+
+	void do_deallocate(void* pMemory, size_t bytes, size_t alignment) override {
+		m_pUpstream->deallocate(pMemory, bytes, alignment);
+	}
+
+	bool do_is_equal(const pmr::memory_resource& other) const noexcept override {
+		return this == &other;
+	}
+public:
+	explicit JsonStatsResource(pmr::memory_resource* pUpstream) : m_pUpstream(pUpstream) {}
+};
+#else
+#define SIMPLEJSON_STAT(statement) do {} while (0)
+#define SIMPLEJSON_STAT_TIMER(phase)
+#endif
+
+//----------------------------- STRING ESCAPES ------------------------------//
+
+/**
+ * @brief find the first quote or backslash at or after pos, or also the first control character if includeControl is set
+ * with SSE2 the text is scanned 16 bytes at a time, so runs of plain characters are skipped in bulk
+ */
+inline size_t findJsonSpecial(string_view text, size_t pos, bool includeControl) {
+#ifdef __SSE2__
+	const __m128i quote = _mm_set1_epi8('\"');
+	const __m128i backslash = _mm_set1_epi8('\\');
+	const __m128i lastControl = _mm_set1_epi8(0x1F);
+	for (; pos + 16 <= text.size(); pos += 16) {
+		__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + pos));
+		__m128i special = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash));
+		if (includeControl) special = _mm_or_si128(special, _mm_cmpeq_epi8(_mm_min_epu8(chunk, lastControl), chunk));	//unsigned chunk <= 0x1F
+		int mask = _mm_movemask_epi8(special);
+		if (mask) return pos + __builtin_ctz(mask);
+	}
+#endif
+	for (; pos < text.size(); pos++) {
+		unsigned char character = text[pos];
+		if (character == '\"' || character == '\\' || (includeControl && character < 0x20)) return pos;
+	}
+	return string_view::npos;
+}
+
+/**
+ * @brief read the four hex digits of a \u escape
+ */
+constexpr uint32_t readJsonHex(string_view text, size_t pos) {
+	uint32_t value = 0;
+	if (pos + 4 > text.size()) throw invalid_argument("string is not a valid json");
+	for (size_t i = pos; i < pos + 4; i++) {
+		char character = text[i];
+		value <<= 4;
+		if (character >= '0' && character <= '9') value |= character - '0';
+		else if (character >= 'a' && character <= 'f') value |= character - 'a' + 10;
+		else if (character >= 'A' && character <= 'F') value |= character - 'A' + 10;
+		else throw invalid_argument("string is not a valid json");
+	}
+	return value;
+}
+
+/**
+ * @brief write a code point as utf-8, returning the number of bytes written
+ */
+constexpr size_t writeUtf8(uint32_t codePoint, char* pOutput) {
+	if (codePoint < 0x80) {
+		pOutput[0] = static_cast<char>(codePoint);
+		return 1;
+	}
+	if (codePoint < 0x800) {
+		pOutput[0] = static_cast<char>(0xC0 | (codePoint >> 6));
+		pOutput[1] = static_cast<char>(0x80 | (codePoint & 0x3F));
+		return 2;
+	}
+	if (codePoint < 0x10000) {
+		pOutput[0] = static_cast<char>(0xE0 | (codePoint >> 12));
+		pOutput[1] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+		pOutput[2] = static_cast<char>(0x80 | (codePoint & 0x3F));
+		return 3;
+	}
+	pOutput[0] = static_cast<char>(0xF0 | (codePoint >> 18));
+	pOutput[1] = static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+	pOutput[2] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+	pOutput[3] = static_cast<char>(0x80 | (codePoint & 0x3F));
+	return 4;
+}
+
+/**
+ * @brief decode the escape sequence whose backslash is at text[in], moving in past it and returning the number of bytes written
+ * the whole sequence is read before anything is written, so pOutput may overlap it. Unpaired surrogates decode to U+FFFD
+ */
+constexpr size_t decodeJsonEscape(string_view text, size_t& in, char* pOutput) {
+	if (in + 1 >= text.size()) throw invalid_argument("string is not a valid json");
+	char escaped = text[in + 1];
+	in += 2;
+	switch (escaped) {
+		case '\"':
+		case '\\':
+		case '/':
+			pOutput[0] = escaped;
+			return 1;
+		case 'b':
+			pOutput[0] = '\b';
+			return 1;
+		case 'f':
+			pOutput[0] = '\f';
+			return 1;
+		case 'n':
+			pOutput[0] = '\n';
+			return 1;
+		case 'r':
+			pOutput[0] = '\r';
+			return 1;
+		case 't':
+			pOutput[0] = '\t';
+			return 1;
+		case 'u': {
+			uint32_t codePoint = readJsonHex(text, in);
+			in += 4;
+			if (codePoint >= 0xD800 && codePoint <= 0xDBFF && in + 6 <= text.size() && text[in] == '\\' && text[in + 1] == 'u') {
+				uint32_t low = readJsonHex(text, in + 2);
+				if (low >= 0xDC00 && low <= 0xDFFF) {
+					codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+					in += 6;
+				}
+			}
+			if (codePoint >= 0xD800 && codePoint <= 0xDFFF) codePoint = 0xFFFD;
+			return writeUtf8(codePoint, pOutput);
+		}
+		default:
+			throw invalid_argument("string is not a valid json");
+	}
+}
+
+/**
+ * @brief decode the escape sequences of a json string in place and return its new size
+ * decoding never makes a string longer, so the output can overwrite the input. Unpaired surrogates decode to U+FFFD
+ */
+inline size_t unescapeJsonString(char* pData, size_t size) {
+	string_view text(pData, size);
+	size_t in = text.find('\\');
+	if (in == string_view::npos) return size;
+	size_t out = in;
+	while (in < size) {
+		size_t next = findJsonSpecial(text, in, false);
+		if (next == string_view::npos) next = size;
+		memmove(pData + out, pData + in, next - in);	//copy the run of plain characters in one go
+		out += next - in;
+		in = next;
+		if (in == size) break;
+		if (pData[in] == '\"') {
+			pData[out++] = pData[in++];
+			continue;
+		}
+		out += decodeJsonEscape(text, in, pData + out);
+	}
+	return out;
+}
+
+/**
+ * @brief append a string to json output, escaping quotes, backslashes and control characters
+ */
+inline void appendEscaped(string& output, string_view text) {
+	static constexpr char s_hexDigits[] = "0123456789abcdef";
+	size_t pos = 0;
+	while (true) {
+		size_t next = findJsonSpecial(text, pos, true);
+		if (next == string_view::npos) {
+			output.append(text.substr(pos));
+			return;
+		}
+		output.append(text.substr(pos, next - pos));
+		unsigned char character = text[next];
+		switch (character) {
+			case '\"':
+				output.append("\\\"");
+				break;
+			case '\\':
+				output.append("\\\\");
+				break;
+			case '\b':
+				output.append("\\b");
+				break;
+			case '\f':
+				output.append("\\f");
+				break;
+			case '\n':
+				output.append("\\n");
+				break;
+			case '\r':
+				output.append("\\r");
+				break;
+			case '\t':
+				output.append("\\t");
+				break;
+			default: {
+				char unicode[] = {'\\', 'u', '0', '0', s_hexDigits[character >> 4], s_hexDigits[character & 0xF]};
+				output.append(unicode, sizeof(unicode));
+			}
+		}
+		pos = next + 1;
+	}
+}
+
+//----------------------------- UTF-8 VALIDATION ------------------------------//
+
+/**
+ * @brief return the position of the first non-ascii byte at or after pos, or size if there is none - checks 8 bytes at a time
+ */
+inline size_t skipAsciiScalar(const char* pData, size_t pos, size_t size) {
+	for (; pos + 8 <= size; pos += 8) {
+		uint64_t block;
+		memcpy(&block, pData + pos, sizeof(block));
+		if (block & 0x8080808080808080ull) break;
+	}
+	while (pos < size && !(pData[pos] & 0x80)) pos++;
+	return pos;
+}
+
+#ifdef __SSE2__
+/**
+ * @brief skipAsciiScalar checking 16 bytes at a time
+ */
+inline size_t skipAsciiSse2(const char* pData, size_t pos, size_t size) {
+	for (; pos + 16 <= size; pos += 16) {
+		int mask = _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pData + pos)));
+		if (mask) return pos + __builtin_ctz(mask);
+	}
+	return skipAsciiScalar(pData, pos, size);
+}
+#endif
+
+#ifdef SIMPLEJSON_AVX2_DISPATCH
+/**
+ * @brief skipAsciiScalar checking 32 bytes at a time
+ */
+__attribute__((target("avx2"))) inline size_t skipAsciiAvx2(const char* pData, size_t pos, size_t size) {
+	for (; pos + 32 <= size; pos += 32) {
+		unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pData + pos))));
+		if (mask) return pos + __builtin_ctz(mask);
+	}
+	return skipAsciiScalar(pData, pos, size);
+}
+#endif
+
+/**
+ * @brief pick the widest ascii scan the cpu supports
+ */
+inline size_t (*selectAsciiSkipper())(const char*, size_t, size_t) {
+#ifdef SIMPLEJSON_AVX2_DISPATCH
+	__builtin_cpu_init();	//may be called during static initialisation, before the cpu model is otherwise set up
+	if (__builtin_cpu_supports("avx2")) return skipAsciiAvx2;
+#endif
+#ifdef __SSE2__
+	return skipAsciiSse2;
+#else
+	return skipAsciiScalar;
+#endif
+}
+
+/**
+ * @brief return the length of the multi-byte utf-8 sequence starting at pos, or 0 if it is invalid
+ * rejects overlong encodings, surrogates and code points above U+10FFFF
+ */
+inline size_t utf8SequenceLength(const unsigned char* pData, size_t pos, size_t size) {
+	unsigned char lead = pData[pos];
+	size_t length;
+	unsigned char low = 0x80, high = 0xBF;	//allowed range of the first continuation byte
+	if (lead >= 0xC2 && lead <= 0xDF) {
+		length = 2;
+	} else if (lead >= 0xE0 && lead <= 0xEF) {
+		length = 3;
+		if (lead == 0xE0) low = 0xA0;
+		if (lead == 0xED) high = 0x9F;
+	} else if (lead >= 0xF0 && lead <= 0xF4) {
+		length = 4;
+		if (lead == 0xF0) low = 0x90;
+		if (lead == 0xF4) high = 0x8F;
+	} else {
+		return 0;
+	}
+	if (pos + length > size) return 0;
+	if (pData[pos + 1] < low || pData[pos + 1] > high) return 0;
+	for (size_t i = 2; i < length; i++)
+		if ((pData[pos + i] & 0xC0) != 0x80) return 0;
+	return length;
+}
+
+/**
+ * @brief check that text is valid utf-8
+ * runs of ascii are skipped with the widest vector scan the cpu supports, chosen once at runtime, and only multi-byte sequences are decoded
+ */
+inline bool isValidUtf8(string_view text) {
+	static size_t (*const s_skipAscii)(const char*, size_t, size_t) = selectAsciiSkipper();
+	const unsigned char* pData = reinterpret_cast<const unsigned char*>(text.data());
+	size_t pos = 0;
+	while (true) {
+		pos = s_skipAscii(text.data(), pos, text.size());
+		if (pos == text.size()) return true;
+		size_t length = utf8SequenceLength(pData, pos, text.size());
+		if (!length) return false;
+		pos += length;
+	}
+}
+
+//----------------------------- CANONICAL FORM ------------------------------//
+
+/**
+ * @brief append a number the way ECMAScript prints it, as RFC 8785 requires - the shortest digits that round trip,
+ * in plain notation from 1e-6 up to 1e21 and exponential notation outside that range
+ */
+inline void appendCanonicalNumber(string& output, double value) {
+	if (value == 0) {
+		output.push_back('0');	//including -0
+		return;
+	}
+	char buffer[32];
+	to_chars_result result = to_chars(buffer, buffer + sizeof(buffer), value, chars_format::scientific);
+	string_view text(buffer, result.ptr - buffer);	//[-]d[.ddd]e[+-]dd
+	if (text[0] == '-') {
+		output.push_back('-');
+		text.remove_prefix(1);
+	}
+	size_t exponentPos = text.find('e');
+	char digits[24];
+	int digitCount = 0;
+	for (char character : text.substr(0, exponentPos))
+		if (character != '.') digits[digitCount++] = character;
+	int exponent = 0;
+	string_view exponentText = text.substr(exponentPos + 1);
+	bool negativeExponent = exponentText[0] == '-';
+	from_chars(exponentText.data() + 1, exponentText.data() + exponentText.size(), exponent);
+	int pointPos = (negativeExponent ? -exponent : exponent) + 1;	//digits before the decimal point
+	if (digitCount <= pointPos && pointPos <= 21) {
+		output.append(digits, digitCount).append(pointPos - digitCount, '0');
+	} else if (0 < pointPos && pointPos <= 21) {
+		output.append(digits, pointPos).append(".").append(digits + pointPos, digitCount - pointPos);
+	} else if (-6 < pointPos && pointPos <= 0) {
+		output.append("0.").append(-pointPos, '0').append(digits, digitCount);
+	} else {
+		output.push_back(digits[0]);
+		if (digitCount > 1) output.append(".").append(digits + 1, digitCount - 1);
+		output.append(pointPos > 0 ? "e+" : "e-").append(to_string(abs(pointPos - 1)));
+	}
+}
+
+/**
+ * @brief decode the code point starting at pos, without validation
+ */
+inline uint32_t decodeUtf8(string_view text, size_t pos) {
+	unsigned char lead = text[pos];
+	size_t length = lead < 0xC0 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+	uint32_t codePoint = length == 1 ? lead : lead & (0x3F >> (length - 1));
+	for (size_t i = 1; i < length && pos + i < text.size(); i++)
+		codePoint = (codePoint << 6) | (static_cast<unsigned char>(text[pos + i]) & 0x3F);
+	return codePoint;
+}
+
+/**
+ * @brief order keys by their utf-16 code units, as RFC 8785 requires
+ * this matches utf-8 byte order except that characters above U+FFFF sort before U+E000 to U+FFFF, so only those are decoded
+ */
+inline bool utf16Less(string_view left, string_view right) {
+	size_t length = min(left.size(), right.size());
+	size_t pos = 0;
+	while (pos < length && left[pos] == right[pos]) pos++;
+	if (pos == length) return left.size() < right.size();
+	unsigned char leftByte = left[pos], rightByte = right[pos];
+	if (leftByte < 0x80 || rightByte < 0x80) return leftByte < rightByte;
+	while (pos > 0 && (static_cast<unsigned char>(left[pos]) & 0xC0) == 0x80) pos--;	//back up to the start of the differing character
+	uint32_t leftCode = decodeUtf8(left, pos), rightCode = decodeUtf8(right, pos);
+	uint32_t leftUnit = leftCode < 0x10000 ? leftCode : 0xD800 + ((leftCode - 0x10000) >> 10);
+	uint32_t rightUnit = rightCode < 0x10000 ? rightCode : 0xD800 + ((rightCode - 0x10000) >> 10);
+	if (leftUnit != rightUnit) return leftUnit < rightUnit;
+	return leftCode < rightCode;	//same high surrogate, so the low surrogates follow code point order
+}
+
+//----------------------------- NUMBER PARSING ------------------------------//
+
+/**
+ * @brief check that text follows the json number grammar: -? (0 | [1-9][0-9]*) (. [0-9]+)? ([eE] [+-]? [0-9]+)?
+ * from_chars alone also accepts inf, nan, leading zeros and a bare decimal point
+ */
+constexpr bool isJsonNumber(string_view text) {
+	size_t pos = 0;
+	auto digits = [&text, &pos] {
+		size_t start = pos;
+		while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') pos++;
+		return pos - start;
+	};
+	if (pos < text.size() && text[pos] == '-') pos++;
+	if (pos < text.size() && text[pos] == '0') {
+		pos++;
+	} else if (!digits()) {
+		return false;
+	}
+	if (pos < text.size() && text[pos] == '.') {
+		pos++;
+		if (!digits()) return false;
+	}
+	if (pos < text.size() && (text[pos] == 'e' || text[pos] == 'E')) {
+		pos++;
+		if (pos < text.size() && (text[pos] == '-' || text[pos] == '+')) pos++;
+		if (!digits()) return false;
+	}
+	return pos == text.size();
+}
+
+/**
+ * @brief check if 8 bytes are all ascii digits, testing them together in one 64 bit word
+ */
+inline bool isEightDigits(const char* pData) {
+	uint64_t block;
+	memcpy(&block, pData, sizeof(block));
+	return (((block & 0xF0F0F0F0F0F0F0F0ull) | (((block + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) == 0x3333333333333333ull);
+}
+
+/**
+ * @brief convert 8 ascii digits to their value by combining pairs, then pairs of pairs, within one 64 bit word
+ */
+inline uint64_t parseEightDigits(const char* pData) {
+	uint64_t block;
+	memcpy(&block, pData, sizeof(block));
+	block -= 0x3030303030303030ull;
+	block = (block * 10) + (block >> 8);
+	block = (((block & 0x000000FF000000FFull) * (100 + (1000000ull << 32))) + (((block >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32)))) >> 32;
+	return block;
+}
+
+/**
+ * @brief read digits into value, at most maxDigits so it cannot overflow, returning how many were read
+ * on little endian targets whole blocks of 8 digits are converted at once
+ */
+inline size_t parseDigits(const char* pBegin, const char* pEnd, uint64_t& value, size_t maxDigits) {
+	const char* pData = pBegin;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	while (pEnd - pData >= 8 && size_t(pData - pBegin) + 8 <= maxDigits && isEightDigits(pData)) {
+		value = value * 100000000 + parseEightDigits(pData);
+		pData += 8;
+	}
+#endif
+	while (pData < pEnd && size_t(pData - pBegin) < maxDigits && *pData >= '0' && *pData <= '9') {
+		value = value * 10 + (*pData - '0');
+		pData++;
+	}
+	return pData - pBegin;
+}
+
+/**
+ * @brief convert the whole of text to a number, returning false if it does not follow the json number grammar or does not fit in T
+ * integers of up to 19 digits and doubles with up to 19 significant digits and a power of ten up to 22 are converted exactly
+ * from the digits (the fast path of Clinger's algorithm) - anything else goes through from_chars
+ */
+template<typename T>
+bool parseJsonNumber(string_view text, T& value) {
+	const char* pData = text.data();
+	const char* pEnd = pData + text.size();
+	bool negative = pData < pEnd && *pData == '-';
+	if (negative) pData++;
+	//json needs a digit first and allows no leading zeros, which also rules out inf and nan
+	if (pData == pEnd || *pData < '0' || *pData > '9' || (*pData == '0' && pData + 1 < pEnd && pData[1] >= '0' && pData[1] <= '9')) return false;
+	uint64_t mantissa = 0;
+	size_t digits = parseDigits(pData, pEnd, mantissa, 19);
+	pData += digits;
+	if constexpr (is_integral_v<T>) {
+		if (digits > 0 && digits < 19 && pData == pEnd) {
+			if (!negative && mantissa <= uint64_t(numeric_limits<T>::max())) {
+				value = T(mantissa);
+				return true;
+			}
+			if (negative && is_signed_v<T> && mantissa <= uint64_t(numeric_limits<T>::max()) + 1) {
+				value = T(0 - mantissa);
+				return true;
+			}
+		}
+	} else if constexpr (is_same_v<T, double>) {
+		static constexpr double s_powersOfTen[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+		int exponent = 0;
+		size_t totalDigits = digits;
+		if (pData < pEnd && *pData == '.') {
+			if (pData + 1 == pEnd || pData[1] < '0' || pData[1] > '9') return false;	//json needs a digit after the point
+			size_t fractionDigits = parseDigits(pData + 1, pEnd, mantissa, 19 - totalDigits);
+			pData += fractionDigits + 1;
+			totalDigits += fractionDigits;
+			exponent -= int(fractionDigits);
+		}
+		if (pData < pEnd && (*pData == 'e' || *pData == 'E')) {
+			pData++;
+			bool negativeExponent = pData < pEnd && *pData == '-';
+			if (pData < pEnd && (*pData == '-' || *pData == '+')) pData++;
+			uint64_t exponentValue = 0;
+			size_t exponentDigits = parseDigits(pData, pEnd, exponentValue, 4);
+			pData += exponentDigits;
+			if (!exponentDigits) pData = nullptr;	//not a number, leave it to from_chars to reject
+			exponent += negativeExponent ? -int(exponentValue) : int(exponentValue);
+		}
+		if (pData == pEnd && digits > 0 && mantissa <= (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22) {
+			double number = double(mantissa);
+			number = exponent < 0 ? number / s_powersOfTen[-exponent] : number * s_powersOfTen[exponent];
+			value = negative ? -number : number;
+			return true;
+		}
+	}
+	if (!isJsonNumber(text)) return false;	//from_chars is more lenient than json
+	from_chars_result result = from_chars(text.data(), text.data() + text.size(), value);
+	return result.ec == errc() && result.ptr == text.data() + text.size();
+}
+
+/**
+ * @class CompactString
+ * 16 byte string used for element keys and values. Up to 15 characters are stored inline with no allocation,
+ * longer strings on the heap, and interned keys as a pointer to storage owned by a KeyPool
+ * Heap blocks come from a memory resource chosen by whoever assigns the string, and start with a pointer to that resource
+ * so the block can be returned to it without the string growing
+ * The last byte is a tag: for inline strings it holds the unused inline capacity, so a full inline string is still null terminated
+ * The size of heap and external strings is stored in 32 bits, so strings are limited to MAX_SIZE characters
+ */
+class CompactString {
+private:
+	static constexpr uint8_t INLINE_CAPACITY = 15;
+	static constexpr uint8_t HEAP = 0x40;
+	static constexpr uint8_t EXTERNAL = 0x80;
+	static constexpr size_t MIN_HEAP_CAPACITY = 32;
+
+	//heap and external strings store a pointer in bytes 0-7, the size in bytes 8-11 and log2 of the heap capacity in byte 12
+	alignas(8) char m_bytes[16];
+
+	//a heap block is the owning memory resource followed by the characters
+	static constexpr size_t HEAP_HEADER = sizeof(pmr::memory_resource*);
+
+	uint8_t tag() const {
+		return static_cast<uint8_t>(m_bytes[15]);
+	}
+
+	const char* pointer() const {
+		const char* pData;
+		memcpy(&pData, m_bytes, sizeof(pData));
+		return pData;
+	}
+
+	uint32_t pointerSize() const {
+		uint32_t size;
+		memcpy(&size, m_bytes + 8, sizeof(size));
+		return size;
+	}
+
+	size_t heapCapacity() const {
+		return size_t(1) << static_cast<uint8_t>(m_bytes[12]);
+	}
+
+	/**
+	 * @brief throw before storing a string whose size would not fit in 32 bits
+	 */
+	static void checkSize(size_t size) {
+		if (size > MAX_SIZE) throw invalid_argument("string is too long to store");
+	}
+
+	void setPointer(const char* pData, size_t size, uint8_t tag) {
+		uint32_t size32 = static_cast<uint32_t>(size);
+		memcpy(m_bytes, &pData, sizeof(pData));
+		memcpy(m_bytes + 8, &size32, sizeof(size32));
+		m_bytes[15] = static_cast<char>(tag);
+	}
+
+	void setInline(const char* pData, size_t size) {
+		memcpy(m_bytes, pData, size);
+		m_bytes[size] = '\0';
+		m_bytes[15] = static_cast<char>(INLINE_CAPACITY - size);
+	}
+
+	/**
+	 * @brief return the memory resource that owns the heap block
+	 */
+	pmr::memory_resource* heapResource() const {
+		pmr::memory_resource* pResource;
+		memcpy(&pResource, pointer() - HEAP_HEADER, sizeof(pResource));
+		return pResource;
+	}
+
+	/**
+	 * @brief copy into a new heap buffer sized to the next power of two
+	 */
+	void allocate(const char* pData, size_t size, pmr::memory_resource* pResource) {
+		uint8_t capacityLog2 = 5;
+		while ((size_t(1) << capacityLog2) < max(size + 1, MIN_HEAP_CAPACITY)) capacityLog2++;
+		char* pBlock = static_cast<char*>(pResource->allocate(HEAP_HEADER + (size_t(1) << capacityLog2), alignof(pmr::memory_resource*)));
+		memcpy(pBlock, &pResource, sizeof(pResource));
+		char* pHeap = pBlock + HEAP_HEADER;
+		memcpy(pHeap, pData, size);
+		pHeap[size] = '\0';
+		release();
+		setPointer(pHeap, size, HEAP);
+		m_bytes[12] = static_cast<char>(capacityLog2);
+	}
+
+	/**
+	 * @brief free any heap storage and become an empty inline string
+	 */
+	void release() {
+		if (isHeap()) heapResource()->deallocate(const_cast<char*>(pointer()) - HEAP_HEADER, HEAP_HEADER + heapCapacity(), alignof(pmr::memory_resource*));
+		setInline("", 0);
+	}
+public:
+	static constexpr size_t MAX_SIZE = numeric_limits<uint32_t>::max();	//longest string whose size fits in the 32 bit size field
+
+	CompactString() {
+		setInline("", 0);
+	}
+
+	CompactString(const CompactString& other) {
+		setInline("", 0);
+		*this = other;
+	}
+
+	CompactString(CompactString&& other) noexcept {
+		memcpy(m_bytes, other.m_bytes, sizeof(m_bytes));
+		other.setInline("", 0);
+	}
+
+	~CompactString() {
+		release();
+	}
+
+	CompactString& operator=(const CompactString& other) {
+		if (this == &other) return *this;
+		if (other.isExternal()) {
+			release();
+			memcpy(m_bytes, other.m_bytes, sizeof(m_bytes));
+		} else {
+			assign(other.view(), other.isHeap() ? other.heapResource() : pmr::null_memory_resource());	//an inline string never allocates
+		}
+		return *this;
+	}
+
+	CompactString& operator=(CompactString&& other) noexcept {
+		if (this == &other) return *this;
+		release();
+		memcpy(m_bytes, other.m_bytes, sizeof(m_bytes));
+		other.setInline("", 0);
+		return *this;
+	}
+
+	bool isHeap() const {
+		return tag() == HEAP;
+	}
+
+	bool isExternal() const {
+		return tag() == EXTERNAL;
+	}
+
+	const char* data() const {
+		return tag() <= INLINE_CAPACITY ? m_bytes : pointer();
+	}
+
+	size_t size() const {
+		return tag() <= INLINE_CAPACITY ? INLINE_CAPACITY - tag() : pointerSize();
+	}
+
+	bool empty() const {
+		return size() == 0;
+	}
+
+	string_view view() const {
+		return string_view(data(), size());
+	}
+
+	/**
+	 * @brief copy a value in, reusing existing heap storage when it is large enough and otherwise allocating from pResource
+	 */
+	void assign(string_view value, pmr::memory_resource* pResource) {
+		checkSize(value.size());
+		if (isHeap() && value.size() < heapCapacity()) {
+			char* pHeap = const_cast<char*>(pointer());
+			memmove(pHeap, value.data(), value.size());
+			pHeap[value.size()] = '\0';
+			setPointer(pHeap, value.size(), HEAP);
+		} else if (value.size() <= INLINE_CAPACITY) {
+			if (isExternal()) setInline("", 0);
+			char buffer[INLINE_CAPACITY];
+			memcpy(buffer, value.data(), value.size());	//value may point into this string
+			setInline(buffer, value.size());
+		} else {
+			allocate(value.data(), value.size(), pResource);
+		}
+	}
+
+	/**
+	 * @brief copy in the contents of a json string, decoding its escape sequences
+	 */
+	void assignUnescaped(string_view value, pmr::memory_resource* pResource) {
+		assign(value, pResource);
+		if (value.find('\\') == string_view::npos) return;
+		char* pData = const_cast<char*>(data());
+		size_t size = unescapeJsonString(pData, value.size());
+		pData[size] = '\0';
+		if (isHeap()) setPointer(pData, size, HEAP);
+		else m_bytes[15] = static_cast<char>(INLINE_CAPACITY - size);
+	}
+
+	/**
+	 * @brief point at a string owned elsewhere, which must outlive this one
+	 */
+	void assignExternal(string_view value) {
+		checkSize(value.size());
+		release();
+		setPointer(value.data(), value.size(), EXTERNAL);
+	}
+
+	/**
+	 * @brief empty the string, keeping any heap storage for reuse
+	 */
+	void clear() {
+		if (isHeap()) {
+			const_cast<char*>(pointer())[0] = '\0';
+			setPointer(pointer(), 0, HEAP);
+		} else {
+			setInline("", 0);
+		}
+	}
+
+	/**
+	 * @brief return heap storage that is larger than the string needs
+	 */
+	void shrinkToFit() {
+		if (!isHeap()) return;
+		string_view value = view();
+		if (value.size() <= INLINE_CAPACITY) {
+			char buffer[INLINE_CAPACITY];
+			memcpy(buffer, value.data(), value.size());
+			release();
+			setInline(buffer, value.size());
+		} else if (heapCapacity() > max(MIN_HEAP_CAPACITY, value.size() + 1) * 2) {
+			allocate(value.data(), value.size(), heapResource());
+		}
+	}
+
+	/**
+	 * @brief return the bytes of heap storage owned by this string
+	 */
+	size_t heapBytes() const {
+		return isHeap() ? HEAP_HEADER + heapCapacity() : 0;
+	}
+};
+
 /**
  * @class Element
  * Data structure for storing individual elements of the json object
@@ -12,8 +894,14 @@ using namespace std;
 */
 class Element {
 friend class SimpleJson;
+friend class FrozenJson;
+friend class JsonView;
+template<typename Value> friend class JsonChildIterator;
+#ifdef SIMPLEJSON_STATS
+friend struct JsonStats;
+#endif
 private:
-	enum valueType {
+	enum valueType : uint8_t {
 		UNKNOWN,
 		EMPTY,
 		STRING,
@@ -24,25 +912,18 @@ private:
 	};
 
 	/**
-	 * @brief constructor for Element class - initialise member variables
+	 * @brief constructor for Element class - member variables are initialised where they are declared
 	*/
-	Element() {
-		string m_key = "";
-		string m_value = "";
-		int m_valueType = EMPTY;
-		Element* m_pNextElement = nullptr;
-		Element* m_pParentElement = nullptr;
-		Element* m_pChildElement = nullptr;
-		Element* m_pPrevElement = nullptr;
-	}
-
-	string m_key;
-	string m_value;
-	int m_valueType = EMPTY;
+	Element() {}
+
+	//laid out to fit in 64 bytes: three links, two 16 byte strings, a one byte type and a four byte index
 	Element* m_pNextElement = nullptr;
 	Element* m_pParentElement = nullptr;
 	Element* m_pChildElement = nullptr;
-	Element* m_pPrevElement = nullptr;
+	CompactString m_key;	//interned keys point into the document's KeyPool
+	CompactString m_value;
+	uint8_t m_valueType = EMPTY;
+	uint32_t m_index = 0;	//position among its siblings, only kept up to date when hashing subtrees
 
 	/**
 	 * @brief return the next element
@@ -66,20 +947,18 @@ private:
 	}
 
 	/**
-	 * @brief copy child element to new pointer
+	 * @brief copy child element into a newly allocated element
 	 */
-	void copyChild() {
-		Element* pNewElement = new Element;
+	void copyChild(Element* pNewElement) {
 		*pNewElement = *m_pChildElement;
 		m_pChildElement = pNewElement;
 		m_pChildElement->m_pParentElement = this;
 	}
 
 	/**
-	 * @brief copy next element to new pointer
+	 * @brief copy next element into a newly allocated element
 	 */
-	void copyNext() {
-		Element* pNewElement = new Element;
+	void copyNext(Element* pNewElement) {
 		*pNewElement = *m_pNextElement;
 		m_pNextElement = pNewElement;
 		m_pNextElement->m_pParentElement = m_pParentElement;
@@ -90,8 +969,8 @@ private:
 	 * this function cleans the values of the old parent element so that it acts as the new base element
 	 */
 	void cleanFirstElement() {
-		m_key = "";
-		m_value = "";
+		m_key.clear();
+		m_value.clear();
 		m_pNextElement = nullptr;	//set next element to null to mark the end of the new element tree
 		m_pParentElement = nullptr;
 	}
@@ -100,19 +979,19 @@ private:
 	 * @brief when get() is called on a primitive element (i.e. not object or array) we need to remove the key and all connected elements
 	 */
 	void cleanOnlyElement() {
-		m_key = "";
+		m_key.clear();
 		m_pNextElement = nullptr;
 		m_pParentElement = nullptr;
 		m_pChildElement = nullptr;
-		m_pPrevElement = nullptr;
 	}
 
 	/**
 	 * @brief set the value and valueType of the element. In some cases we need to specify the valueType, in others we infer it from the value itself
+	 * long values are stored in memory from pResource, the document's memory resource
 	*/
-	void setValue(string value, int type=UNKNOWN) {
+	void setValue(string_view value, pmr::memory_resource* pResource, int type=UNKNOWN) {
 		//need to check for non empty string plus UNknown (do I mean empty string plus unknown ?)
-		m_value = value;
+		m_value.assign(value, pResource);
 		if (value == "") {
 			m_valueType = type;
 			return;
@@ -121,7 +1000,7 @@ private:
 			int start = value.find_first_of('\"');
 			int end = value.find_last_of('\"');
 			m_valueType = STRING;
-			m_value = value.substr(start+1,end-1);
+			m_value.assignUnescaped(value.substr(start+1,end-1), pResource);
 			return;
 		}
 		if (value == "true" || value == "false") {
@@ -139,30 +1018,41 @@ private:
 	 * @brief get the key from an element to append to json string during serialization
 	 */
 	string getKey() {
-		if (!getParent()) return "\"" + m_key + "\": ";
+		if (!getParent()) return getEscapedKey();
 		switch (m_pParentElement->m_valueType) {
 			case ARRAY:
 				return "";
 			case OBJECT:
-				return "\"" + m_key + "\": ";
+				return getEscapedKey();
 			default:
 				throw invalid_argument("object structure corrupted");
 		}
 	}
 
+	/**
+	 * @brief get the key quoted and escaped for json output
+	 */
+	string getEscapedKey() {
+		string key = "\"";
+		appendEscaped(key, getKeyRaw());
+		return key.append("\": ");
+	}
+
 	/**
 	 * @brief get the value from an element - if valueType is string need to add "" for json serialization
 	 */
 	string getValueForJson() {
-		if (m_valueType == STRING) return "\"" + m_value + "\"";
-		return m_value;
+		if (m_valueType != STRING) return string(m_value.view());
+		string value = "\"";
+		appendEscaped(value, m_value.view());
+		return value.append("\"");
 	}
 
 	/**
 	 * @brief get the value from an element when returning raw value
 	 */
 	string getValueRaw() {
-		return m_value;
+		return string(m_value.view());
 	}
 
 	/**
@@ -197,51 +1087,513 @@ private:
 	/**
 	 * @brief set the key for an element
 	 */
-	void setKey(string key) {
-		m_key = key;
+	void setKey(string_view key, pmr::memory_resource* pResource) {
+		m_key.assign(key, pResource);
 	}
 
 	/**
-	 * @brief check if a given string can be treated as a number when saving elements value
+	 * @brief set the key for an element to a key stored in the document's KeyPool
 	 */
-	static bool isFloat( string value ) {
-		istringstream testStream(value);
-		float testFloat;
-		testStream >> noskipws >> testFloat;
-		return testStream.eof() && !testStream.fail(); 
+	void setInternedKey(const pmr::string* pKey) {
+		m_key.assignExternal(*pKey);
 	}
 
 	/**
-	 * @brief set the value of the element identified by key() to a bool 
-	*/
-	void setBool(bool value) {
-		string strValue = value ? "true" : "false";
-		setValue(strValue);
+	 * @brief check if the element's key is the given interned key - interned keys are compared by pointer
+	 */
+	bool hasInternedKey(const pmr::string* pKey) const {
+		return m_key.isExternal() && m_key.data() == pKey->data();
 	}
 
 	/**
-	 * @brief set the value of the element identified by key() to a string 
-	*/
-	void setString(string value) {
-		setValue("\"" + value + "\"");
+	 * @brief get the key from an element
+	 */
+	string_view getKeyRaw() const {
+		return m_key.view();
 	}
 
 	/**
-	 * @brief set the value of the element identified by key() to a float 
-	*/
-	void setFloat(float value) {
-		setValue(to_string(value));
+	 * @brief check if this is the empty element the parser leaves as the only child of an empty array or object
+	 */
+	bool isPlaceholder() const {
+		return m_pParentElement && m_pParentElement->m_pChildElement == this && !m_pNextElement && !m_pChildElement && m_valueType == EMPTY && m_value.empty();
 	}
 
 	/**
-	 * @brief set the value of the element identified by key() to null
-	*/
-	void setNull() {
-		setValue("null");
+	 * @brief check if a given string can be treated as a number when saving elements value
+	 * uses from_chars rather than a stringstream so checking a value does not allocate
+	 */
+	static bool isFloat( string_view value ) {
+		if (!isJsonNumber(value)) return false;
+		float testFloat;
+		from_chars_result result = from_chars(value.data(), value.data() + value.size(), testFloat);
+		return result.ec == errc() && result.ptr == value.data() + value.size();
 	}
-};
-
-
+
+	/**
+	 * @brief return the element to its freshly constructed state, keeping the capacity of its strings so it can be reused
+	 */
+	void recycle() {
+		m_key.clear();
+		m_value.clear();
+		m_valueType = EMPTY;
+		m_index = 0;
+		m_pNextElement = nullptr;
+		m_pParentElement = nullptr;
+		m_pChildElement = nullptr;
+	}
+
+	/**
+	 * @brief set the value of the element identified by key() to a bool 
+	*/
+	void setBool(bool value, pmr::memory_resource* pResource) {
+		string strValue = value ? "true" : "false";
+		setValue(strValue, pResource);
+	}
+
+	/**
+	 * @brief set the value of the element identified by key() to a string 
+	*/
+	void setString(string value, pmr::memory_resource* pResource) {
+		m_value.assign(value, pResource);
+		m_valueType = STRING;
+	}
+
+	/**
+	 * @brief set the value of the element identified by key() to a float 
+	*/
+	void setFloat(float value, pmr::memory_resource* pResource) {
+		setValue(to_string(value), pResource);
+	}
+
+	/**
+	 * @brief set the value of the element identified by key() to null
+	*/
+	void setNull(pmr::memory_resource* pResource) {
+		setValue("null", pResource);
+	}
+};
+
+#ifdef SIMPLEJSON_STATS
+/**
+ * @brief count an element of the parsed tree by its value type
+ */
+inline void JsonStats::countElement(const Element& element) {
+	switch (element.m_valueType) {
+		case Element::STRING:
+			strings++;
+			break;
+		case Element::BOOL:
+			bools++;
+			break;
+		case Element::NUMBER:
+			numbers++;
+			break;
+		case Element::OBJECT:
+			objects++;
+			break;
+		case Element::ARRAY:
+			arrays++;
+			break;
+		default:
+			nulls++;
+	}
+}
+#endif
+
+
+
+class FrozenJson;
+
+/**
+ * @class JsonOptions
+ * optional behaviour chosen when a SimpleJson is constructed
+ */
+struct JsonOptions {
+	bool internKeys = false;	//store each distinct object key once in a KeyPool and compare keys by pointer
+	bool validateUtf8 = false;	//reject input whose strings are not valid utf-8
+	bool hashSubtrees = false;	//keep a structural hash of every array and object for fast equality and diff
+	pmr::memory_resource* memoryResource = nullptr;	//where the document allocates its elements, strings and indices - the default resource if null, must outlive the document
+};
+
+/**
+ * @brief return the heap storage used by a string, or 0 if the string fits in its inline buffer
+ */
+template<typename String>
+size_t stringHeapBytes(const String& value) {
+	const char* pObject = reinterpret_cast<const char*>(&value);
+	if (value.data() >= pObject && value.data() < pObject + sizeof(String)) return 0;
+	return value.capacity() + 1;
+}
+
+/**
+ * @class TrackingResource
+ * Memory resource which passes allocations on to another resource and keeps count of the bytes still allocated,
+ * for parts of a document whose containers do not report their exact heap use
+ */
+class TrackingResource : public pmr::memory_resource {
+private:
+	pmr::memory_resource* m_pUpstream;
+	size_t m_bytes = 0;
+
+	void* do_allocate(size_t bytes, size_t alignment) override {
+		void* pMemory = m_pUpstream->allocate(bytes, alignment);
+		m_bytes += bytes;
+		return pMemory;
+	}
+
+	void do_deallocate(void* pMemory, size_t bytes, size_t alignment) override {
+		m_pUpstream->deallocate(pMemory, bytes, alignment);
+		m_bytes -= bytes;
+	}
+
+	bool do_is_equal(const pmr::memory_resource& other) const noexcept override {
+		return this == &other;
+	}
+public:
+	explicit TrackingResource(pmr::memory_resource* pUpstream) : m_pUpstream(pUpstream) {}
+
+	TrackingResource(const TrackingResource&) = delete;
+	TrackingResource& operator=(const TrackingResource&) = delete;
+
+	/**
+	 * @brief return the bytes allocated through this resource and not yet returned
+	 */
+	size_t bytes() const {
+		return m_bytes;
+	}
+};
+
+/**
+ * @class KeyPool
+ * Dictionary of the object keys in a document. Each distinct key is stored once and shared by every element using it,
+ * so arrays of records with the same keys do not repeat them and keys can be compared by pointer
+ */
+class KeyPool {
+private:
+	TrackingResource m_resource;	//declared first so it outlives the containers using it
+	pmr::deque<pmr::string> m_keys;	//deque so stored keys never move as more are added
+	pmr::unordered_map<string_view, const pmr::string*> m_lookup;
+public:
+	/**
+	 * @brief constructor - the keys and the lookup table are allocated from pResource
+	 */
+	KeyPool(pmr::memory_resource* pResource = pmr::get_default_resource()) : m_resource(pResource), m_keys(&m_resource), m_lookup(&m_resource) {}
+
+	/**
+	 * @brief return the shared copy of a key, adding it to the pool if it is new
+	 */
+	const pmr::string* intern(string_view key) {
+		auto found = m_lookup.find(key);
+		if (found != m_lookup.end()) return found->second;
+		const pmr::string* pKey = &m_keys.emplace_back(key);
+		m_lookup.emplace(*pKey, pKey);
+		return pKey;
+	}
+
+	/**
+	 * @brief return the shared copy of a key, or nullptr if the key is not in the pool
+	 */
+	const pmr::string* find(string_view key) const {
+		auto found = m_lookup.find(key);
+		return found == m_lookup.end() ? nullptr : found->second;
+	}
+
+	/**
+	 * @brief forget every key - no element may still point at one
+	 */
+	void clear() {
+		m_lookup.clear();
+		m_keys.clear();
+	}
+
+	/**
+	 * @brief return the number of distinct keys
+	 */
+	size_t size() const {
+		return m_keys.size();
+	}
+
+	/**
+	 * @brief bytes allocated by the pool: the key strings and their heap storage, plus the lookup table's nodes and buckets
+	 */
+	size_t memoryUsage() const {
+		return sizeof(KeyPool) + m_resource.bytes();
+	}
+};
+
+/**
+ * @class JsonMemoryUsage
+ * bytes held by a SimpleJson document, by category
+ */
+struct JsonMemoryUsage {
+	size_t document = 0;		//the SimpleJson object itself
+	size_t elements = 0;		//element nodes
+	size_t strings = 0;			//heap storage of element keys and values
+	size_t elementIndex = 0;	//lists of owned element pointers
+	size_t proxies = 0;			//proxies left behind by key()
+	size_t retainedStrings = 0;	//copies of the input kept after parsing
+	size_t internedKeys = 0;	//the key pool, which may be shared with documents returned by get()
+
+	size_t total() const {
+		return document + elements + strings + elementIndex + proxies + retainedStrings + internedKeys;
+	}
+};
+
+//----------------------------- VIEWS ------------------------------//
+
+template<typename Value> class JsonChildIterator;
+template<typename Iterator> class JsonRange;
+struct JsonMember;
+
+/**
+ * @class JsonView
+ * non-owning handle to one element of a SimpleJson, with the same get methods as SimpleJson but without copying the subtree
+ * a view is valid until the document it came from is modified, reparsed or destroyed
+ */
+class JsonView {
+private:
+	const Element* m_pElement;
+
+	JsonView(const Element* pElement) : m_pElement(pElement) {}
+
+	/**
+	 * @brief first child of a container, skipping the empty placeholder element the parser leaves in an empty container
+	 */
+	const Element* firstChild() const {
+		const Element* pChild = m_pElement->m_pChildElement;
+		if (pChild && pChild->isPlaceholder()) return nullptr;
+		return pChild;
+	}
+
+	const Element* firstArrayItem() const {
+		if (!isArray()) throw invalid_argument("element is not an array");
+		return firstChild();
+	}
+
+	/**
+	 * @brief convert one array item for toVector() and copyTo()
+	 */
+	template<typename T>
+	static T convertItem(const Element* pElement) {
+		if constexpr (is_same_v<T, bool>) {
+			if (pElement->m_valueType != Element::valueType::BOOL) throw invalid_argument("element is not a bool");
+			return pElement->m_value.view() == "true";
+		} else if constexpr (is_same_v<T, string_view> || is_same_v<T, string>) {
+			if (pElement->m_valueType != Element::valueType::STRING) throw invalid_argument("element is not a string");
+			return T(pElement->m_value.view());
+		} else {
+			static_assert(is_arithmetic_v<T>, "arrays can only be converted to bool, string, string_view or arithmetic types");
+			T value{};
+			if (pElement->m_valueType != Element::valueType::NUMBER || !parseJsonNumber(pElement->m_value.view(), value)) throw invalid_argument("element is not a number");
+			return value;
+		}
+	}
+
+	friend class SimpleJson;
+	template<typename Value> friend class JsonChildIterator;
+public:
+	/**
+	 * @brief get json value by key from the top layer of this element
+	 */
+	JsonView get(string_view key) const {
+		if (m_pElement->m_valueType == Element::valueType::ARRAY) throw invalid_argument("cannot get an array by key");
+		for (const Element* pChild = firstChild(); pChild; pChild = pChild->m_pNextElement) {
+			if (pChild->m_key.view() == key) return JsonView(pChild);
+		}
+		throw invalid_argument("could not find this key");
+	}
+
+	/**
+	 * @brief get json value by index from the top layer of this element
+	 */
+	JsonView get(int index) const {
+		if (m_pElement->m_valueType == Element::valueType::OBJECT) throw invalid_argument("cannot get an object by index");
+		const Element* pChild = firstChild();
+		for (int i = 0; i < index && pChild; i++) pChild = pChild->m_pNextElement;
+		if (index < 0 || !pChild) throw invalid_argument("could not find this index");
+		return JsonView(pChild);
+	}
+
+	/**
+	 * @brief return the number of children of an object or array
+	 */
+	size_t size() const {
+		size_t count = 0;
+		for (const Element* pChild = firstChild(); pChild; pChild = pChild->m_pNextElement) count++;
+		return count;
+	}
+
+	bool isObject() const {
+		return m_pElement->m_valueType == Element::valueType::OBJECT;
+	}
+
+	bool isArray() const {
+		return m_pElement->m_valueType == Element::valueType::ARRAY;
+	}
+
+	bool isNull() const {
+		return m_pElement->m_valueType == Element::valueType::EMPTY;
+	}
+
+	bool isBool() const {
+		return m_pElement->m_valueType == Element::valueType::BOOL;
+	}
+
+	bool getBool() const {
+		if (!isBool()) throw invalid_argument("element is not a bool");
+		return m_pElement->m_value.view() == "true";
+	}
+
+	bool isString() const {
+		return m_pElement->m_valueType == Element::valueType::STRING;
+	}
+
+	/**
+	 * @brief return a view of the decoded string value
+	 */
+	string_view getString() const {
+		if (!isString()) throw invalid_argument("element is not a string");
+		return m_pElement->m_value.view();
+	}
+
+	bool isFloat() const {
+		return m_pElement->m_valueType == Element::valueType::NUMBER;
+	}
+
+	float getFloat() const {
+		float number = 0;
+		if (!isFloat() || !parseJsonNumber(m_pElement->m_value.view(), number)) throw invalid_argument("element is not a number");
+		return number;
+	}
+
+	/**
+	 * @brief convert every item of an array to T - T can be bool, string, string_view or any arithmetic type
+	 * the items are counted first so the vector is allocated once, then converted in a single pass
+	 * string_views point into the document. Throws if an item is not of the matching json type or does not fit in T
+	 */
+	template<typename T>
+	vector<T> toVector() const {
+		vector<T> values;
+		values.reserve(size());
+		for (const Element* pChild = firstArrayItem(); pChild; pChild = pChild->m_pNextElement)
+			values.push_back(convertItem<T>(pChild));
+		return values;
+	}
+
+	/**
+	 * @brief convert every item of an array into a buffer provided by the caller in a single pass, returning the number of items written
+	 * throws if the array has more than capacity items, once the buffer has been filled
+	 */
+	template<typename T>
+	size_t copyTo(T* pOutput, size_t capacity) const {
+		size_t count = 0;
+		for (const Element* pChild = firstArrayItem(); pChild; pChild = pChild->m_pNextElement) {
+			if (count == capacity) throw invalid_argument("array is larger than the buffer");
+			pOutput[count++] = convertItem<T>(pChild);
+		}
+		return count;
+	}
+
+	/**
+	 * @brief iterate the values of an array or object, in order
+	 */
+	JsonRange<JsonChildIterator<JsonView>> items() const;
+
+	/**
+	 * @brief iterate the key/value pairs of an object, in order
+	 */
+	JsonRange<JsonChildIterator<JsonMember>> members() const;
+};
+
+/**
+ * @class JsonMember
+ * key and value of an object member, as yielded by JsonView::members()
+ */
+struct JsonMember {
+	string_view key;
+	JsonView value;
+};
+
+/**
+ * @class JsonChildIterator
+ * forward iterator over the children of an element, following the next element chain - each step is a pointer chase with no allocation
+ */
+template<typename Value>
+class JsonChildIterator {
+private:
+	const Element* m_pElement = nullptr;
+public:
+	using iterator_category = forward_iterator_tag;
+	using value_type = Value;
+	using difference_type = ptrdiff_t;
+	using pointer = void;
+	using reference = Value;
+
+	JsonChildIterator() {}
+	explicit JsonChildIterator(const Element* pElement) : m_pElement(pElement) {}
+
+	Value operator*() const {
+		if constexpr (is_same_v<Value, JsonMember>) {
+			return JsonMember{m_pElement->m_key.view(), JsonView(m_pElement)};
+		} else {
+			return JsonView(m_pElement);
+		}
+	}
+
+	JsonChildIterator& operator++() {
+		m_pElement = m_pElement->m_pNextElement;
+		return *this;
+	}
+
+	JsonChildIterator operator++(int) {
+		JsonChildIterator previous = *this;
+		++*this;
+		return previous;
+	}
+
+	bool operator==(const JsonChildIterator& other) const {
+		return m_pElement == other.m_pElement;
+	}
+
+	bool operator!=(const JsonChildIterator& other) const {
+		return m_pElement != other.m_pElement;
+	}
+};
+
+/**
+ * @class JsonRange
+ * begin/end pair so children can be iterated with range-for and passed to <algorithm>
+ */
+template<typename Iterator>
+class JsonRange {
+private:
+	Iterator m_begin;
+public:
+	explicit JsonRange(Iterator begin) : m_begin(begin) {}
+
+	Iterator begin() const {
+		return m_begin;
+	}
+
+	Iterator end() const {
+		return Iterator();
+	}
+
+	bool empty() const {
+		return m_begin == Iterator();
+	}
+};
+
+inline JsonRange<JsonChildIterator<JsonView>> JsonView::items() const {
+	if (!isObject() && !isArray()) throw invalid_argument("element is not an array or object");
+	return JsonRange<JsonChildIterator<JsonView>>(JsonChildIterator<JsonView>(firstChild()));
+}
+
+inline JsonRange<JsonChildIterator<JsonMember>> JsonView::members() const {
+	if (!isObject()) throw invalid_argument("element is not an object");
+	return JsonRange<JsonChildIterator<JsonMember>>(JsonChildIterator<JsonMember>(firstChild()));
+}
 
 /**
  * @class SimpleJson
@@ -250,19 +1602,35 @@ private:
 */
 class SimpleJson {
 private:
-	string m_jsonString;
-	string m_cleanString;
-	string m_parseString;
+#ifdef SIMPLEJSON_STATS
+	shared_ptr<JsonStatsResource> m_pStatsResource;	//counts allocations, shared with documents returned by get() as their strings may come from it
+#endif
+	pmr::memory_resource* m_pResource;	//elements, strings and indices are all allocated from here, declared first so the members below can use it
+	pmr::string m_jsonString {m_pResource};
+	pmr::string m_cleanString {m_pResource};
+	pmr::string m_parseString {m_pResource};
 	bool m_exitingParent = false;
 	bool m_backToStart = false;
 	int m_delimiterPos;
 	Element* m_pFirstElement;
-	list<Element*> m_pElements;
+	pmr::string m_keyBuffer {m_pResource};	//while parsing, holds keys that contained escape sequences once decoded
+	Element* m_pPrevElement = nullptr;	//while parsing, the element whose next pointer holds the element created by addLastChild
+	pmr::vector<Element*> m_pElements {m_pResource};
+	pmr::vector<Element*> m_pFreeElements {m_pResource};	//elements kept by reset() to be reused by the next parse
+	Element* m_pElementBlock = nullptr;	//elements packed together by compact()
+	size_t m_elementBlockSize = 0;
+	bool m_validateUtf8 = false;
+	bool m_hashSubtrees = false;	//each container's m_value holds the sum of its children's hashes
+	shared_ptr<KeyPool> m_pKeyPool;	//only set when keys are interned, shared with documents returned by get()
+#ifdef SIMPLEJSON_STATS
+	size_t m_parseDepth = 0;
+#endif
 public:
 	/**
 	 * @brief constructor - deserialize a json string
 	*/
-	SimpleJson(string input) {
+	SimpleJson(string input, JsonOptions options = JsonOptions()) : m_pResource(selectResource(options.memoryResource)) {
+		applyOptions(options);
 		cleanAndParse(input);
 	}
 
@@ -270,28 +1638,116 @@ public:
 	 * @brief constructor - deserialize a json file
 	 * @param stream - std::ifstream of file to be parsed
 	*/
-	SimpleJson(ifstream &stream) {
+	SimpleJson(ifstream &stream, JsonOptions options = JsonOptions()) : m_pResource(selectResource(options.memoryResource)) {
+		applyOptions(options);
 		string input((istreambuf_iterator<char>(stream)), istreambuf_iterator<char>());
 		cleanAndParse(input);
 	}
 
+	/**
+	 * @brief move constructor - take over the other document's elements and strings, leaving it empty so it can only be destroyed
+	 * proxies already returned by the other document's key() stay with it
+	 */
+	SimpleJson(SimpleJson&& other) :
+#ifdef SIMPLEJSON_STATS
+		m_pStatsResource(std::move(other.m_pStatsResource)),
+#endif
+		m_pResource(other.m_pResource),
+		m_jsonString(std::move(other.m_jsonString)),
+		m_cleanString(std::move(other.m_cleanString)),
+		m_parseString(std::move(other.m_parseString)),
+		m_delimiterPos(other.m_delimiterPos),
+		m_pFirstElement(exchange(other.m_pFirstElement, nullptr)),
+		m_keyBuffer(std::move(other.m_keyBuffer)),
+		m_pElements(std::move(other.m_pElements)),
+		m_pFreeElements(std::move(other.m_pFreeElements)),
+		m_pElementBlock(exchange(other.m_pElementBlock, nullptr)),
+		m_elementBlockSize(exchange(other.m_elementBlockSize, 0)),
+		m_validateUtf8(other.m_validateUtf8),
+		m_hashSubtrees(other.m_hashSubtrees),
+		m_pKeyPool(std::move(other.m_pKeyPool)) {
+		other.m_pElements.clear();
+		other.m_pFreeElements.clear();
+	}
+
 	/**
 	 * @brief destructor - delete all elements of the json object
 	 */
 	~SimpleJson() {
-		for (Element* element:m_pElements)
-			delete element;
+		deleteElements(m_pElements);
+		deleteElements(m_pFreeElements);
 		for (Proxy* proxy:m_pProxys)
-			delete proxy;
-		m_pElements.clear();
+			destroyObject(&m_proxyResource, proxy);
+		deleteElementBlock();
+	}
+
+	/**
+	 * @brief discard the current document, leaving a json null, but keep its elements and string capacity to be reused by the next parse
+	 * a block packed by compact() is released rather than reused
+	 */
+	void reset() {
+		recycleElements();
+		setNullDocument();
+	}
+
+	/**
+	 * @brief deserialize a new json string into this object, reusing the storage of the previous document
+	 * parsing messages of a similar shape performs no heap allocation once the storage has grown to fit them
+	 * if the input is not valid json the document is left as a json null
+	 */
+	void reparse(const string& input) {
+		recycleElements();
+		try {
+			cleanAndParse(input);
+		} catch (...) {
+			recycleElements();
+			setNullDocument();
+			throw;
+		}
 	}
 private:
 	/**
-	 * @brief constructor - create a new SimpleJson object from an existing one
+	 * @brief move every element of the document to the free list and release proxies, leaving no first element
+	 * an interned key pool is emptied too unless a document returned by get() still shares it, so reparsing documents with
+	 * ever changing keys does not grow it without bound
+	 */
+	void recycleElements() {
+		for (Proxy* proxy:m_pProxys)
+			destroyObject(&m_proxyResource, proxy);
+		m_pProxys.clear();
+		m_pFreeElements.reserve(m_pFreeElements.size() + m_pElements.size());
+		//push in reverse so elements are reused in the order they were first created
+		for (auto it = m_pElements.rbegin(); it != m_pElements.rend(); it++) {
+			(*it)->recycle();
+			m_pFreeElements.push_back(*it);
+		}
+		m_pElements.clear();
+		deleteElementBlock();
+		m_pFirstElement = nullptr;
+		if (m_pKeyPool && m_pKeyPool.use_count() == 1) m_pKeyPool->clear();
+	}
+
+	/**
+	 * @brief make the document a single json null
+	 */
+	void setNullDocument() {
+		m_jsonString.clear();
+		m_pFirstElement = newElement();
+		m_pFirstElement->setNull(m_pResource);
+		m_pElements.push_back(m_pFirstElement);
+	}
+
+	/**
+	 * @brief constructor - create a new SimpleJson object from an existing one, sharing the source document's options and memory resource
 	 */
-	SimpleJson (Element* baseElement) {
+	SimpleJson (Element* baseElement, const SimpleJson* pSource = nullptr) : m_pResource(pSource ? shareResource(*pSource) : selectResource(nullptr)) {
 		if (!baseElement) throw invalid_argument("tried to create a json object with NULL first element");
-		m_pFirstElement = new Element();
+		if (pSource) {
+			m_validateUtf8 = pSource->m_validateUtf8;
+			m_hashSubtrees = pSource->m_hashSubtrees;
+			m_pKeyPool = pSource->m_pKeyPool;
+		}
+		m_pFirstElement = newElement();
 		*m_pFirstElement = *(baseElement);
 		if (isPrimitiveJson()) {
 			m_pFirstElement->cleanOnlyElement();
@@ -300,10 +1756,43 @@ private:
 		} else {
 			m_pFirstElement->cleanFirstElement();
 			copyElementTree();
+			if (m_hashSubtrees) hashContainer(m_pFirstElement);	//the copied children keep their hashes, only the cleaned first element needs one
 			m_jsonString = generateJsonString();
 		}
 	}
 
+	/**
+	 * @brief choose the memory resource for a new document - called before the members that allocate are constructed
+	 */
+	pmr::memory_resource* selectResource(pmr::memory_resource* pResource) {
+		if (!pResource) pResource = pmr::get_default_resource();
+#ifdef SIMPLEJSON_STATS
+		m_pStatsResource = make_shared<JsonStatsResource>(pResource);
+		return m_pStatsResource.get();
+#else
+		return pResource;
+#endif
+	}
+
+	/**
+	 * @brief use the memory resource of the document this one is copied from
+	 */
+	pmr::memory_resource* shareResource(const SimpleJson& source) {
+#ifdef SIMPLEJSON_STATS
+		m_pStatsResource = source.m_pStatsResource;
+#endif
+		return source.m_pResource;
+	}
+
+	/**
+	 * @brief set up the document according to the options it was constructed with
+	 */
+	void applyOptions(const JsonOptions& options) {
+		if (options.internKeys) m_pKeyPool = allocate_shared<KeyPool>(pmr::polymorphic_allocator<KeyPool>(m_pResource), m_pResource);
+		m_validateUtf8 = options.validateUtf8;
+		m_hashSubtrees = options.hashSubtrees;
+	}
+
 	//----------------------------- DATA STRUCTURE METHODS ------------------------------//
 
 	/**
@@ -313,13 +1802,65 @@ private:
 		return m_pFirstElement->m_valueType != Element::valueType::OBJECT && m_pFirstElement->m_valueType != Element::valueType::ARRAY;
 	}
 
+	/**
+	 * @brief allocate an object from one of the document's memory resources and construct it
+	 */
+	template<typename T, typename... Args>
+	static T* createObject(pmr::memory_resource* pResource, Args&&... args) {
+		void* pMemory = pResource->allocate(sizeof(T), alignof(T));
+		return new (pMemory) T(std::forward<Args>(args)...);
+	}
+
+	/**
+	 * @brief destroy an object made by createObject and return its memory to the resource it came from
+	 */
+	template<typename T>
+	static void destroyObject(pmr::memory_resource* pResource, T* pObject) {
+		pObject->~T();
+		pResource->deallocate(pObject, sizeof(T), alignof(T));
+	}
+
+	/**
+	 * @brief allocate a new element
+	 */
+	Element* newElement() {
+		if (!m_pFreeElements.empty()) {
+			Element* pElement = m_pFreeElements.back();
+			m_pFreeElements.pop_back();
+			return pElement;
+		}
+		return createObject<Element>(m_pResource);
+	}
+
+	/**
+	 * @brief delete the elements in a list and clear it
+	 */
+	void deleteElements(pmr::vector<Element*>& elements) {
+		for (Element* element:elements)
+			destroyObject(m_pResource, element);
+		elements.clear();
+	}
+
+	/**
+	 * @brief delete the block of elements packed by compact(), if there is one
+	 */
+	void deleteElementBlock() {
+		if (!m_pElementBlock) return;
+		for (size_t i = 0; i < m_elementBlockSize; i++)
+			m_pElementBlock[i].~Element();
+		m_pResource->deallocate(m_pElementBlock, m_elementBlockSize * sizeof(Element), alignof(Element));
+		m_pElementBlock = nullptr;
+		m_elementBlockSize = 0;
+	}
+
 	/**
 	 * @brief save the current Element into the element tree and create a new element to be populated on the same branch
 	*/
 	Element* addElement (Element* pCurrentElement) {
-		Element* pNewElement = new Element();
+		Element* pNewElement = newElement();
 		pCurrentElement->m_pNextElement = pNewElement;
 		pNewElement->m_pParentElement = pCurrentElement->m_pParentElement;
+		pNewElement->m_index = pCurrentElement->m_index + 1;
 		m_pElements.push_back(pNewElement);
 		return pNewElement;
 	}
@@ -328,7 +1869,7 @@ private:
 	 * @brief save the current Element to the element tree and create a new child element to be populated on a new branch
 	 */
 	Element* addChild (Element* pCurrentElement) {
-		Element* pNewElement = new Element();
+		Element* pNewElement = newElement();
 		pCurrentElement->m_pChildElement = pNewElement;
 		pNewElement->m_pParentElement = pCurrentElement;
 		m_pElements.push_back(pNewElement);
@@ -339,9 +1880,9 @@ private:
 	 * @brief save the current Element to the element tree and close off a branch, then create a new element to be populated on the parent branch
 	 */
 	Element* addLastChild (Element* pCurrentElement) {
-		Element* pNewElement = new Element();
+		Element* pNewElement = newElement();
 		pNewElement->m_pParentElement = pCurrentElement->m_pParentElement->m_pParentElement;
-		pNewElement->m_pPrevElement = pCurrentElement->m_pParentElement;
+		m_pPrevElement = pCurrentElement->m_pParentElement;
 		pCurrentElement->m_pParentElement->m_pNextElement = pNewElement;
 		m_pElements.push_back(pNewElement);
 		return pNewElement;
@@ -358,16 +1899,17 @@ private:
 	 * @brief If exiting more than one parent in a row in generateJsonString, we need to move the element we created up to the next parent
 	 */
 	void moveNextUp (Element* pCurrentElement) {
-		pCurrentElement->m_pPrevElement->m_pNextElement = nullptr;
+		m_pPrevElement->m_pNextElement = nullptr;
 		if (backToStart(pCurrentElement)) {
-			//we have reached the end of the list - delete the new element
-			m_pElements.remove(pCurrentElement);
-			delete pCurrentElement;
+			//we have reached the end of the list - the new element is always the last one added, so return it to the free list
+			m_pElements.pop_back();
+			pCurrentElement->recycle();
+			m_pFreeElements.push_back(pCurrentElement);
 			m_backToStart = true;
 			return;
 		}
 		pCurrentElement->m_pParentElement->m_pNextElement = pCurrentElement;
-		pCurrentElement->m_pPrevElement = pCurrentElement->m_pParentElement;
+		m_pPrevElement = pCurrentElement->m_pParentElement;
 		pCurrentElement->m_pParentElement = pCurrentElement->m_pParentElement->m_pParentElement;
 	}
 
@@ -386,17 +1928,39 @@ private:
 	}
 
 	/**
-	 * @brief create a copy of the element tree starting from a given first element
+	 * @brief list the elements reachable from the first element, parents before children and siblings in order
 	 */
-	void copyElementTree() {
+	vector<Element*> elementsInTreeOrder() {
+		vector<Element*> order;
 		Element* pElement = m_pFirstElement;
-		while(pElement) {
+		while (pElement) {
+			order.push_back(pElement);
 			if (pElement->getChild()) {
-				pElement->copyChild();
-				m_pElements.push_back(pElement);
 				pElement = pElement->getChild();
 			} else if (pElement->getNext()) {
-				pElement->copyNext();
+				pElement = pElement->getNext();
+			} else {
+				pElement = exitBranch(pElement);
+			}
+		}
+		return order;
+	}
+
+	/**
+	 * @brief create a copy of the element tree starting from a given first element
+	 */
+	void copyElementTree() {
+		SIMPLEJSON_STAT_TIMER(copyTime);
+		Element* pElement = m_pFirstElement;
+		while(pElement) {
+			SIMPLEJSON_STAT(elementsCopied++);
+			if (pElement->getChild()) {
+				pElement->copyChild(newElement());
+				if (pElement->getNext()) pElement->copyNext(newElement());	//exitBranch will come back to the next element, so it must be a copy by then
+				m_pElements.push_back(pElement);
+				pElement = pElement->getChild();
+			} else if (pElement->getNext()) {
+				pElement->copyNext(newElement());
 				m_pElements.push_back(pElement);
 				pElement = pElement->getNext();
 			} else if (pElement->getParent()) {
@@ -414,7 +1978,7 @@ private:
 	 * 
 	 * @brief clean the input json string then deserialize it to build the element tree
 	*/
-	void cleanAndParse(string input) {
+	void cleanAndParse(const string& input) {
 		m_jsonString = input;
 		parseJsonString(m_jsonString);
 	}
@@ -423,14 +1987,14 @@ private:
 	 * @brief find the next special character in json string and remove whitespace
 	*/
 	char findNextDelimiter() {
-		bool insideString = false;
 		for (int i = 0; i<m_parseString.size();) {
 			m_delimiterPos = i;
 			char& character = m_parseString[i];
 			i++;
-			if (character == '\"') insideString = !insideString;
-			if (insideString) continue;
 			switch (character) {
+				case '\"':
+					i = skipString(i);
+					continue;
 				case ':':
 					return ':';
 				case ',':
@@ -456,11 +2020,39 @@ private:
 		throw invalid_argument("string is not a valid json");
 	}
 
+	/**
+	 * @brief return the position after the closing quote of a string starting at pos, skipping escaped characters
+	 * when validating, the string is checked as it is scanned - outside strings, anything but ascii fails to parse as a value
+	 */
+	int skipString(int pos) {
+		string_view parseString = m_parseString;
+		size_t start = pos;
+		while (true) {
+			size_t special = findJsonSpecial(parseString, pos, false);
+			if (special == string_view::npos) throw invalid_argument("string is not a valid json");
+			if (parseString[special] == '\"') {
+				if (m_validateUtf8 && !isValidUtf8(parseString.substr(start, special - start))) throw invalid_argument("string is not valid utf-8");
+				return special + 1;
+			}
+			pos = special + 2;
+		}
+	}
+
 	/**
 	 * @brief consume next colon to get the current element's key
 	 */
 	void handleColon(Element* pElement) {
-		pElement->setKey(m_parseString.substr(1, m_delimiterPos-2));
+		string_view key = string_view(m_parseString).substr(1, m_delimiterPos-2);
+		if (key.find('\\') != string_view::npos) {
+			m_keyBuffer.assign(key);
+			m_keyBuffer.resize(unescapeJsonString(m_keyBuffer.data(), m_keyBuffer.size()));
+			key = m_keyBuffer;
+		}
+		if (m_pKeyPool) {
+			pElement->setInternedKey(m_pKeyPool->intern(key));
+		} else {
+			pElement->setKey(key, m_pResource);
+		}
 		m_parseString.erase(0, m_delimiterPos+1);
 	}
 
@@ -474,7 +2066,7 @@ private:
 			m_exitingParent = false;
 			return pElement;
 		} else {
-			pElement->setValue(m_parseString.substr(0, m_delimiterPos), pElement->EMPTY);
+			pElement->setValue(string_view(m_parseString).substr(0, m_delimiterPos), m_pResource, pElement->EMPTY);
 			m_parseString.erase(0, m_delimiterPos+1);
 			return addElement(pElement);
 		}
@@ -484,8 +2076,12 @@ private:
 	 * @brief consume next open bracket to create a new branch of the element tree
 	 */
 	Element* handleOpenBracket(Element* pElement, Element::valueType valueType) {
+#ifdef SIMPLEJSON_STATS
+		m_parseDepth++;
+		SIMPLEJSON_STAT(countDepth(m_parseDepth));
+#endif
 		m_parseString.erase(0, m_delimiterPos+1);
-		pElement->setValue("", valueType);
+		pElement->setValue("", m_pResource, valueType);
 		return addChild(pElement);
 	}
 
@@ -494,12 +2090,15 @@ private:
 	 * special case if prev special char was a close bracket, in this case we move the new element up a layer
 	 */
 	Element* handleCloseBracket(Element* pElement, Element::valueType valueType) {
+#ifdef SIMPLEJSON_STATS
+		m_parseDepth--;
+#endif
 		if (m_exitingParent) {
 			moveNextUp(pElement);
 			m_parseString.erase(0, m_delimiterPos+1);
 			return pElement;
 		} else {
-			pElement->setValue(m_parseString.substr(0, m_delimiterPos), Element::valueType::EMPTY);
+			pElement->setValue(string_view(m_parseString).substr(0, m_delimiterPos), m_pResource, Element::valueType::EMPTY);
 			m_parseString.erase(0, m_delimiterPos+1);
 			if (backToStart(pElement)) return pElement;
 			m_exitingParent = true;
@@ -510,12 +2109,18 @@ private:
 	/**
 	 * @brief deserialize a json string to create its representation as an element tree
 	*/
-	void parseJsonString(string input) {
+	void parseJsonString(string_view input) {
+		SIMPLEJSON_STAT_TIMER(parseTime);
+		SIMPLEJSON_STAT(bytesParsed += input.size());
 		m_parseString = input;
 		m_exitingParent = false;
+		m_backToStart = false;
+#ifdef SIMPLEJSON_STATS
+		m_parseDepth = 0;
+#endif
 		char delimiter;
 
-		Element* pElement = new Element;
+		Element* pElement = newElement();
 		m_pFirstElement = pElement;
 		m_pElements.push_back(pElement);
 
@@ -551,6 +2156,17 @@ private:
 			}
 		}
 		if(m_parseString != "") throw invalid_argument("string is not a valid json");
+		if (m_hashSubtrees) {
+			//elements are created parents first, so walking backwards hashes every child before its parent
+			for (auto it = m_pElements.rbegin(); it != m_pElements.rend(); it++)
+				if (isContainer(*it)) hashContainer(*it);
+		}
+#ifdef SIMPLEJSON_STATS
+		if (JsonStats* pStats = JsonStats::current()) {
+			for (Element* element:m_pElements)
+				pStats->countElement(*element);
+		}
+#endif
 	}
 
 	//----------------------------- SERIALISATION METHODS ------------------------------//
@@ -584,14 +2200,17 @@ private:
 	 * @brief serialize the element tree to output a json string
 	 */
 	string generateJsonString () {
+		SIMPLEJSON_STAT_TIMER(serializeTime);
 		string output;
 		Element* pElement = m_pFirstElement;
 		if (isPrimitiveJson()) {
-			return m_pFirstElement->getValueForJson();
+			output = m_pFirstElement->getValueForJson();
+			SIMPLEJSON_STAT(bytesSerialized += output.size());
+			return output;
 		}
 		bool exitingParent = false;
 		while(pElement) {
-			Element currentElement = *pElement;
+			Element& currentElement = *pElement;
 			if (currentElement.getChild()) {
 				output.append(currentElement.getKey() + currentElement.getOpenBracket()); //could put the first bit in getKey by returning the non empty option if (getChild)
 				pElement = currentElement.getChild();
@@ -606,22 +2225,118 @@ private:
 			}
 		}
 		output = removeLeadingTrailing(output);
+		SIMPLEJSON_STAT(bytesSerialized += output.size());
 		return output;
 	}
+	/**
+	 * @brief write a leaf value in canonical form
+	 */
+	static void appendCanonicalValue(const Element* pElement, string& output) {
+		string_view value = pElement->m_value.view();
+		switch (pElement->m_valueType) {
+			case Element::valueType::STRING:
+				output.push_back('\"');
+				appendEscaped(output, value);
+				output.push_back('\"');
+				return;
+			case Element::valueType::NUMBER: {
+				double number = 0;
+				from_chars_result result = from_chars(value.data(), value.data() + value.size(), number);
+				if (result.ec == errc()) appendCanonicalNumber(output, number);
+				else output.append(value);	//out of range of a double, left as written
+				return;
+			}
+			default:
+				output.append(value.empty() ? "null" : value);
+		}
+	}
+
+	/**
+	 * @brief serialize in the RFC 8785 canonical form: members sorted by key, canonical numbers and no whitespace
+	 * the tree is walked in place - each open container only adds its children's pointers to a shared stack, sorted by key for objects
+	 */
+	void generateCanonicalString(string& output) const {
+		struct Frame {
+			size_t start;	//first of this container's children on the stack
+			size_t next;
+			bool isObject;
+		};
+		vector<const Element*> children;
+		vector<Frame> frames;
+		const Element* pElement = m_pFirstElement;
+		while (pElement) {
+			if (isContainer(pElement)) {
+				bool isObject = pElement->m_valueType == Element::valueType::OBJECT;
+				output.push_back(isObject ? '{' : '[');
+				size_t start = children.size();
+				for (const Element* pChild = pElement->m_pChildElement; pChild; pChild = pChild->m_pNextElement)
+					if (!pChild->isPlaceholder()) children.push_back(pChild);
+				if (isObject) {
+					sort(children.begin() + start, children.end(), [](const Element* pLeft, const Element* pRight) {
+						return utf16Less(pLeft->getKeyRaw(), pRight->getKeyRaw());
+					});
+				}
+				frames.push_back({start, start, isObject});
+			} else {
+				appendCanonicalValue(pElement, output);
+			}
+			//find the next element to write, closing every container that has run out of children
+			pElement = nullptr;
+			while (!frames.empty()) {
+				Frame& frame = frames.back();
+				if (frame.next < children.size()) {	//the top frame's children are always the last on the stack
+					if (frame.next > frame.start) output.push_back(',');
+					pElement = children[frame.next++];
+					if (frame.isObject) {
+						output.push_back('\"');
+						appendEscaped(output, pElement->getKeyRaw());
+						output.append("\":");
+					}
+					break;
+				}
+				output.push_back(frame.isObject ? '}' : ']');
+				children.resize(frame.start);
+				frames.pop_back();
+			}
+		}
+	}
 public:
 	string serialize() {
 		return generateJsonString();
 	}
 
+	/**
+	 * @brief serialize to canonical json (RFC 8785), so documents holding the same data serialize to the same string whatever their member order
+	 * suitable for cache keys and signatures
+	 */
+	string serializeCanonical() const {
+		string output;
+		generateCanonicalString(output);
+		return output;
+	}
+
 	//----------------------------- GET METHODS ------------------------------//
 private:
 	/**
 	 * @brief search the top layer of the element tree for a given key then return that element
 	 */
 	Element* getElement(string key) {
+		SIMPLEJSON_STAT(lookups++);
 		Element* pElement = m_pFirstElement->m_pChildElement;
+		if (m_pKeyPool) {
+			//interned keys are compared by pointer - a key missing from the pool cannot be in the document
+			const pmr::string* pKey = m_pKeyPool->find(key);
+			if (!pKey) return nullptr;
+			while(pElement) {
+				SIMPLEJSON_STAT(lookupSteps++);
+				if (pElement->hasInternedKey(pKey)) return pElement;
+				pElement = pElement->getNext();
+			}
+			return nullptr;
+		}
 		while(pElement) {
-			if (pElement->m_key == key) return pElement;
+			SIMPLEJSON_STAT(lookupSteps++);
+			if (pElement->m_key.view() == key) return pElement;
 			pElement = pElement->getNext();
 		}
 		return nullptr;
@@ -631,9 +2346,11 @@ private:
 	 * @brief return the element at a given index in the top layer of the element tree
 	 */
 	Element* getElement(int index) {
+		SIMPLEJSON_STAT(lookups++);
 		Element* pElement = m_pFirstElement->m_pChildElement;
 		int current = 0;
 		while(pElement) {
+			SIMPLEJSON_STAT(lookupSteps++);
 			if (current == index) return pElement;
 			pElement = pElement->getNext();
 			current++;
@@ -649,7 +2366,7 @@ public:
 		if (m_pFirstElement->m_valueType == Element::valueType::ARRAY) throw invalid_argument("cannot get an array by key");
 		Element* firstElement = getElement(key);
 		if (!firstElement) return NULL;
-		return firstElement;
+		return {firstElement, this};
 	}
 
 	/**
@@ -660,7 +2377,7 @@ public:
 		if (m_pFirstElement->m_valueType == Element::valueType::OBJECT) throw invalid_argument("cannot get an object by index");
 		Element* firstElement = getElement(index);
 		if (!firstElement) return NULL;
-		return firstElement;
+		return {firstElement, this};
 	}
 
 	/**
@@ -675,7 +2392,7 @@ public:
 	 */
 	bool getBool() {
 		if(m_pFirstElement->m_valueType != Element::valueType::BOOL) throw invalid_argument("element is not a bool");
-		return m_pFirstElement->m_value == "true";
+		return m_pFirstElement->m_value.view() == "true";
 	}
 
 	/**
@@ -710,20 +2427,46 @@ public:
 
 	//----------------------------- SET METHODS ------------------------------//
 private:
+	/**
+	 * @brief turn the placeholder the parser leaves in an empty array or object into a null first child, so a set adds to the
+	 * container rather than appending after the placeholder. The key of an object member must be set before calling this
+	 */
+	void claimPlaceholder(Element* pElement) {
+		pElement->setValue("null", m_pResource);
+		if (m_hashSubtrees) updateHashes(pElement, 0, true);
+	}
+
 	/**
 	 * @brief lookup the element to be set specified by its key - if not found add a new element
 	 * The branch to be searched is determined by the starting element passed in. This is needed so the user can set values more than one layer deep in the tree
 	 */
 	Element* findOrAddElement(Element* startingElement, string key) {
+		SIMPLEJSON_STAT(lookups++);
 		Element* pElement = m_pFirstElement->getChild();
 		if (startingElement) pElement = startingElement->getChild();
+		const pmr::string* pKey = m_pKeyPool ? m_pKeyPool->intern(key) : nullptr;
+		if (pElement && pElement->isPlaceholder()) {
+			if (pKey) {
+				pElement->setInternedKey(pKey);
+			} else {
+				pElement->setKey(key, m_pResource);
+			}
+			claimPlaceholder(pElement);
+			return pElement;
+		}
 		while(pElement) {
-			if (pElement->m_key == key) return pElement;
+			SIMPLEJSON_STAT(lookupSteps++);
+			if (pKey ? pElement->hasInternedKey(pKey) : pElement->m_key.view() == key) return pElement;
 			if (pElement->getNext()) {
 				pElement = pElement->getNext();
 			} else {
 				pElement = addElement(pElement);
-				pElement->setKey(key);
+				if (pKey) {
+					pElement->setInternedKey(pKey);
+				} else {
+					pElement->setKey(key, m_pResource);
+				}
+				if (m_hashSubtrees) updateHashes(pElement, 0, true);
 				return pElement;
 			}
 		}
@@ -735,10 +2478,13 @@ private:
 	 * The branch to be searched is determined by the starting element passed in. This is needed so the user can set values more than one layer deep in the tree
 	 */
 	Element* findOrAddElement(Element* startingElement, int index) {
+		SIMPLEJSON_STAT(lookups++);
 		Element* pElement = m_pFirstElement->getChild();
 		if (startingElement) pElement = startingElement->getChild();
+		if (pElement && pElement->isPlaceholder()) claimPlaceholder(pElement);
 		int current = 0;
 		while(pElement) {
+			SIMPLEJSON_STAT(lookupSteps++);
 			if (current == index) return pElement;
 			if (pElement->getNext()) {
 				pElement = pElement->getNext();
@@ -746,7 +2492,8 @@ private:
 				if (current == index) return addElement(pElement);
 				//add empty elements until we reach the specified index
 				pElement = addElement(pElement);
-				pElement->setValue("null");
+				pElement->setValue("null", m_pResource);
+				if (m_hashSubtrees) updateHashes(pElement, 0, true);
 			}
 			current++;
 		}
@@ -789,32 +2536,33 @@ private:
 		 * @brief expose Element::setBool so it can be called straight after a call to key()
 		 */
 		void setBool(bool value) {
-			m_element->setBool(value);
+			m_json.changeElement(m_element, [&] { m_element->setBool(value, m_json.m_pResource); });
 		}
 
 		/**
 		 * @brief expose Element::setString so it can be called straight after a call to key()
 		 */
 		void setString(string value) {
-			m_element->setString(value);
+			m_json.changeElement(m_element, [&] { m_element->setString(value, m_json.m_pResource); });
 		}
 
 		/**
 		 * @brief expose Element::setFloat so it can be called straight after a call to key()
 		 */
 		void setFloat(float value) {
-			m_element->setFloat(value);
+			m_json.changeElement(m_element, [&] { m_element->setFloat(value, m_json.m_pResource); });
 		}
 	};
 private:
-	list<Proxy*> m_pProxys;
+	TrackingResource m_proxyResource {m_pResource};	//holds the proxies and the list of them, so their exact size is known
+	pmr::list<Proxy*> m_pProxys {&m_proxyResource};
 public:
 	/**
 	 * @brief find by key the element whose value should be set in the subsequent call to set()
 	 * returns a temporary proxy object which stores a pointer to the value to be set
 	*/
 	Proxy key (string key) {
-		Proxy* pProxy = new Proxy(*this);
+		Proxy* pProxy = createObject<Proxy>(&m_proxyResource, *this);
 		m_pProxys.push_back(pProxy);
 		return pProxy->key(key);
 	}
@@ -824,8 +2572,1546 @@ public:
 	 * returns a temporary proxy object which stores a pointer to the value to be set
 	*/
 	Proxy key(int index) {
-		Proxy* pProxy = new Proxy(*this);
+		Proxy* pProxy = createObject<Proxy>(&m_proxyResource, *this);
 		m_pProxys.push_back(pProxy);
 		return pProxy->key(index);
 	}
-};
\ No newline at end of file
+
+	//----------------------------- HASH METHODS ------------------------------//
+private:
+	static constexpr uint64_t HASH_MULTIPLIER = 0x9E3779B97F4A7C15ull;
+
+	/**
+	 * @brief scramble a 64 bit value so that sums of hashes do not cancel out - the splitmix64 finalizer
+	 */
+	static uint64_t mixHash(uint64_t value) {
+		value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+		value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+		return value ^ (value >> 31);
+	}
+
+	static uint64_t hashBytes(string_view bytes, uint64_t seed) {
+		uint64_t hash = 0xcbf29ce484222325ull ^ seed;
+		for (char character : bytes) {
+			hash ^= static_cast<unsigned char>(character);
+			hash *= 0x100000001b3ull;
+		}
+		return mixHash(hash);
+	}
+
+	static bool isContainer(const Element* pElement) {
+		return pElement->m_valueType == Element::valueType::OBJECT || pElement->m_valueType == Element::valueType::ARRAY;
+	}
+
+	/**
+	 * @brief sum of the hashes of a container's children, kept in the container's otherwise unused value
+	 */
+	static uint64_t childHashSum(const Element* pElement) {
+		uint64_t sum = 0;
+		if (pElement->m_value.size() == sizeof(sum)) memcpy(&sum, pElement->m_value.data(), sizeof(sum));
+		return sum;
+	}
+
+	static void setChildHashSum(Element* pElement, uint64_t sum) {
+		char bytes[sizeof(sum)];
+		memcpy(bytes, &sum, sizeof(sum));
+		pElement->m_value.assign(string_view(bytes, sizeof(bytes)), pmr::null_memory_resource());	//8 bytes always fit inline
+	}
+
+	/**
+	 * @brief hash of an element's value, ignoring its key
+	 */
+	static uint64_t valueHash(const Element* pElement) {
+		if (isContainer(pElement)) return mixHash(childHashSum(pElement) + pElement->m_valueType);
+		return hashBytes(pElement->m_value.view(), pElement->m_valueType);
+	}
+
+	/**
+	 * @brief hash a child adds to its parent's sum. Object members are hashed with their key, so the sum does not depend on their order,
+	 * array items with their index, so it does
+	 */
+	static uint64_t childHash(const Element* pElement, uint64_t elementHash, size_t index) {
+		if (pElement->isPlaceholder()) return 0;
+		if (pElement->m_pParentElement->m_valueType == Element::valueType::ARRAY) return mixHash(elementHash + (index + 1) * HASH_MULTIPLIER);
+		return mixHash(hashBytes(pElement->getKeyRaw(), 0) + elementHash * HASH_MULTIPLIER);
+	}
+
+	/**
+	 * @brief recompute a container's sum from its children, whose own hashes must already be up to date
+	 * also records each child's index, so updateHashes does not have to count its way along an array
+	 */
+	static void hashContainer(Element* pElement) {
+		uint64_t sum = 0;
+		uint32_t index = 0;
+		for (Element* pChild = pElement->getChild(); pChild; pChild = pChild->getNext()) {
+			pChild->m_index = index;
+			sum += childHash(pChild, valueHash(pChild), index++);
+		}
+		setChildHashSum(pElement, sum);
+	}
+
+	/**
+	 * @brief after an element's value changes, swap its old hash for its new one in each container above it - costs one step per level
+	 * @param oldHash - the element's value hash before the change
+	 * @param added - the element is new, so its parent's sum does not include it yet
+	 */
+	static void updateHashes(Element* pElement, uint64_t oldHash, bool added = false) {
+		while (Element* pParent = pElement->getParent()) {
+			uint64_t oldParentHash = valueHash(pParent);
+			uint64_t sum = childHashSum(pParent) + childHash(pElement, valueHash(pElement), pElement->m_index);
+			if (!added) sum -= childHash(pElement, oldHash, pElement->m_index);
+			setChildHashSum(pParent, sum);
+			pElement = pParent;
+			oldHash = oldParentHash;
+			added = false;
+		}
+	}
+
+	/**
+	 * @brief apply a change to an element's value, keeping the hashes above it up to date
+	 */
+	template<typename Change>
+	void changeElement(Element* pElement, Change change) {
+		if (!m_hashSubtrees) {
+			change();
+			return;
+		}
+		uint64_t oldHash = valueHash(pElement);
+		change();
+		updateHashes(pElement, oldHash);
+	}
+
+	/**
+	 * @brief escape a key for use in a json pointer path
+	 */
+	static void appendPointerToken(string& path, string_view key) {
+		path.append("/");
+		for (char character : key) {
+			if (character == '~') path.append("~0");
+			else if (character == '/') path.append("~1");
+			else path.push_back(character);
+		}
+	}
+
+	/**
+	 * @brief add the paths at which two elements differ, descending only into containers whose hashes differ
+	 */
+	static void diffElements(const Element* pLeft, const Element* pRight, string& path, vector<string>& differences) {
+		if (valueHash(pLeft) == valueHash(pRight)) return;
+		if (!isContainer(pLeft) || pLeft->m_valueType != pRight->m_valueType) {
+			differences.push_back(path);
+			return;
+		}
+		size_t length = path.size();
+		if (pLeft->m_valueType == Element::valueType::ARRAY) {
+			const Element* pLeftChild = pLeft->m_pChildElement;
+			const Element* pRightChild = pRight->m_pChildElement;
+			if (pLeftChild && pLeftChild->isPlaceholder()) pLeftChild = nullptr;
+			if (pRightChild && pRightChild->isPlaceholder()) pRightChild = nullptr;
+			for (size_t index = 0; pLeftChild || pRightChild; index++) {
+				path.append("/").append(to_string(index));
+				if (pLeftChild && pRightChild) diffElements(pLeftChild, pRightChild, path, differences);
+				else differences.push_back(path);
+				path.resize(length);
+				if (pLeftChild) pLeftChild = pLeftChild->m_pNextElement;
+				if (pRightChild) pRightChild = pRightChild->m_pNextElement;
+			}
+			return;
+		}
+		unordered_map<string_view, const Element*> rightMembers;
+		for (const Element* pChild = pRight->m_pChildElement; pChild; pChild = pChild->m_pNextElement)
+			if (!pChild->isPlaceholder()) rightMembers[pChild->getKeyRaw()] = pChild;
+		for (const Element* pChild = pLeft->m_pChildElement; pChild; pChild = pChild->m_pNextElement) {
+			if (pChild->isPlaceholder()) continue;
+			appendPointerToken(path, pChild->getKeyRaw());
+			auto found = rightMembers.find(pChild->getKeyRaw());
+			if (found == rightMembers.end()) {
+				differences.push_back(path);
+			} else {
+				diffElements(pChild, found->second, path, differences);
+				rightMembers.erase(found);
+			}
+			path.resize(length);
+		}
+		for (const Element* pChild = pRight->m_pChildElement; pChild; pChild = pChild->m_pNextElement) {
+			if (!rightMembers.count(pChild->getKeyRaw())) continue;
+			appendPointerToken(path, pChild->getKeyRaw());
+			differences.push_back(path);
+			path.resize(length);
+		}
+	}
+public:
+	/**
+	 * @brief structural hash of the document. Equal documents have equal hashes whatever the order of their object members
+	 * numbers are hashed as the text they are stored as, so 1 and 1.0, or a parsed 2 and setFloat(2), hash differently
+	 * only available when parsed with JsonOptions::hashSubtrees
+	 */
+	uint64_t hash() const {
+		if (!m_hashSubtrees) throw invalid_argument("document was not parsed with hashSubtrees");
+		return valueHash(m_pFirstElement);
+	}
+
+	/**
+	 * @brief check if two documents hold the same json - O(1) by hash when both were parsed with hashSubtrees, otherwise by serializing both
+	 * equality is textual: numbers match only when written the same way
+	 */
+	bool equals(SimpleJson& other) {
+		if (m_hashSubtrees && other.m_hashSubtrees) return hash() == other.hash();
+		return serialize() == other.serialize();
+	}
+
+	/**
+	 * @brief list the json pointer paths (e.g. /person/skills/0) at which two documents differ, including members present in only one of them
+	 * only subtrees whose hashes differ are visited. Both documents must be parsed with hashSubtrees
+	 */
+	vector<string> diff(const SimpleJson& other) const {
+		if (!m_hashSubtrees || !other.m_hashSubtrees) throw invalid_argument("document was not parsed with hashSubtrees");
+		vector<string> differences;
+		string path;
+		diffElements(m_pFirstElement, other.m_pFirstElement, path, differences);
+		return differences;
+	}
+
+	//----------------------------- VIEW METHODS ------------------------------//
+
+	/**
+	 * @brief get a view of the whole document, for reading without copying
+	 */
+	JsonView view() const {
+		return JsonView(m_pFirstElement);
+	}
+
+	/**
+	 * @brief convert every item of the top level array to T, see JsonView::toVector()
+	 */
+	template<typename T>
+	vector<T> toVector() const {
+		return view().toVector<T>();
+	}
+
+	/**
+	 * @brief convert every item of the top level array into a caller's buffer, see JsonView::copyTo()
+	 */
+	template<typename T>
+	size_t copyTo(T* pOutput, size_t capacity) const {
+		return view().copyTo(pOutput, capacity);
+	}
+
+	/**
+	 * @brief iterate the values of the top level array or object without copying them
+	 * for (JsonView item : myJson.items()) { ... }
+	 */
+	JsonRange<JsonChildIterator<JsonView>> items() const {
+		return view().items();
+	}
+
+	/**
+	 * @brief iterate the key/value pairs of the top level object without copying them
+	 * for (auto [key, value] : myJson.members()) { ... }
+	 */
+	JsonRange<JsonChildIterator<JsonMember>> members() const {
+		return view().members();
+	}
+
+	//----------------------------- FREEZE METHODS ------------------------------//
+
+	/**
+	 * @brief create an immutable copy of this document which can be read from many threads without locking
+	 */
+	shared_ptr<const FrozenJson> freeze();
+
+	//----------------------------- MEMORY METHODS ------------------------------//
+private:
+	/**
+	 * @brief release the storage of a string, not just its contents
+	 */
+	static void releaseString(pmr::string& value) {
+		pmr::string(value.get_allocator()).swap(value);
+	}
+public:
+	/**
+	 * @brief report the bytes held by this document, broken down by category
+	 */
+	JsonMemoryUsage memoryUsage() const {
+		JsonMemoryUsage usage;
+		usage.document = sizeof(SimpleJson);
+		usage.elements = (m_pElements.size() + m_pFreeElements.size() + m_elementBlockSize) * sizeof(Element);
+		for (Element* element:m_pElements)
+			usage.strings += element->m_key.heapBytes() + element->m_value.heapBytes();
+		for (Element* element:m_pFreeElements)
+			usage.strings += element->m_key.heapBytes() + element->m_value.heapBytes();
+		for (size_t i = 0; i < m_elementBlockSize; i++)
+			usage.strings += m_pElementBlock[i].m_key.heapBytes() + m_pElementBlock[i].m_value.heapBytes();
+		usage.elementIndex = (m_pElements.capacity() + m_pFreeElements.capacity()) * sizeof(Element*);
+		usage.proxies = m_proxyResource.bytes();
+		usage.retainedStrings = stringHeapBytes(m_jsonString) + stringHeapBytes(m_cleanString) + stringHeapBytes(m_parseString) + stringHeapBytes(m_keyBuffer);
+		if (m_pKeyPool) usage.internedKeys = m_pKeyPool->memoryUsage();
+		return usage;
+	}
+
+	/**
+	 * @brief shrink the document: drop the retained copies of the input, release proxies left behind by key() and
+	 * spare elements kept by reset(), then move all elements into one contiguous block in tree order
+	 */
+	void compact() {
+		releaseString(m_jsonString);
+		releaseString(m_cleanString);
+		releaseString(m_parseString);
+		for (Proxy* proxy:m_pProxys)
+			destroyObject(&m_proxyResource, proxy);
+		m_pProxys.clear();
+
+		//map each element to its slot in the new block
+		vector<Element*> order = elementsInTreeOrder();
+		Element* block = static_cast<Element*>(m_pResource->allocate(order.size() * sizeof(Element), alignof(Element)));
+		for (size_t i = 0; i < order.size(); i++)
+			new (&block[i]) Element();
+		unordered_map<Element*, Element*> moved;
+		for (size_t i = 0; i < order.size(); i++)
+			moved[order[i]] = &block[i];
+		auto relocate = [&moved](Element* pOld) -> Element* {
+			auto found = moved.find(pOld);
+			return found == moved.end() ? nullptr : found->second;
+		};
+		for (size_t i = 0; i < order.size(); i++) {
+			Element& element = block[i];
+			element = std::move(*order[i]);
+			element.m_key.shrinkToFit();
+			element.m_value.shrinkToFit();
+			element.m_pNextElement = relocate(element.m_pNextElement);
+			element.m_pParentElement = relocate(element.m_pParentElement);
+			element.m_pChildElement = relocate(element.m_pChildElement);
+		}
+		m_pFirstElement = &block[0];
+
+		deleteElements(m_pElements);
+		deleteElements(m_pFreeElements);
+		m_pElements.shrink_to_fit();
+		m_pFreeElements.shrink_to_fit();
+		deleteElementBlock();
+		m_pElementBlock = block;
+		m_elementBlockSize = order.size();
+	}
+};
+
+
+//----------------------------- STRUCT MAPPING ------------------------------//
+
+/**
+ * @class JsonReader
+ * Forward-only tokenizer used to read json text straight into typed values without building an element tree
+ */
+class JsonReader {
+private:
+	string_view m_input;
+	size_t m_pos = 0;
+
+	/**
+	 * @brief check if a character can appear in a json number
+	 */
+	static bool isNumberChar(char character) {
+		return (character >= '0' && character <= '9') || character == '-' || character == '+' || character == '.' || character == 'e' || character == 'E';
+	}
+
+	/**
+	 * @brief advance past any whitespace
+	 */
+	void skipWhitespace() {
+		while (m_pos < m_input.size()) {
+			switch (m_input[m_pos]) {
+				case ' ':
+				case '\n':
+				case '\r':
+				case '\t':
+					m_pos++;
+					continue;
+				default:
+					return;
+			}
+		}
+	}
+
+	/**
+	 * @brief consume a literal such as true/false/null if it is next in the input
+	 */
+	bool consumeLiteral(string_view literal) {
+		skipWhitespace();
+		if (m_input.substr(m_pos, literal.size()) != literal) return false;
+		m_pos += literal.size();
+		return true;
+	}
+public:
+	JsonReader(string_view input) : m_input(input) {}
+
+	/**
+	 * @brief return the next non-whitespace character without consuming it
+	 */
+	char peek() {
+		skipWhitespace();
+		if (m_pos >= m_input.size()) throw invalid_argument("string is not a valid json");
+		return m_input[m_pos];
+	}
+
+	/**
+	 * @brief consume the next character if it matches, returning whether it was consumed
+	 */
+	bool consume(char character) {
+		if (peek() != character) return false;
+		m_pos++;
+		return true;
+	}
+
+	/**
+	 * @brief consume the next character, throwing if it does not match
+	 */
+	void expect(char character) {
+		if (!consume(character)) throw invalid_argument("string is not a valid json");
+	}
+
+	/**
+	 * @brief read a quoted string and return its contents without the surrounding quotes
+	 */
+	string_view readRawString() {
+		expect('\"');
+		size_t start = m_pos;
+		while (m_pos < m_input.size()) {
+			char character = m_input[m_pos++];
+			if (character == '\\') {
+				m_pos++;	//skip the escaped character so an escaped quote does not end the string
+			} else if (character == '\"') {
+				return m_input.substr(start, m_pos-1-start);
+			}
+		}
+		throw invalid_argument("string is not a valid json");
+	}
+
+	/**
+	 * @brief read a quoted string into value, decoding its escape sequences
+	 */
+	void readString(string& value) {
+		string_view raw = readRawString();
+		value.assign(raw);
+		value.resize(unescapeJsonString(value.data(), value.size()));
+	}
+
+	/**
+	 * @brief read a json number into an arithmetic type
+	 */
+	template<typename T>
+	T readNumber() {
+		skipWhitespace();
+		size_t start = m_pos;
+		while (m_pos < m_input.size() && isNumberChar(m_input[m_pos])) m_pos++;
+		T value{};
+		if (!parseJsonNumber(m_input.substr(start, m_pos - start), value)) throw invalid_argument("element is not a number");
+		return value;
+	}
+
+	/**
+	 * @brief read a json true/false literal
+	 */
+	bool readBool() {
+		if (consumeLiteral("true")) return true;
+		if (consumeLiteral("false")) return false;
+		throw invalid_argument("element is not a bool");
+	}
+
+	/**
+	 * @brief skip over the next value of any type, used for keys that are not mapped to a struct member
+	 * nested structure is only checked for balanced brackets
+	 */
+	void skipValue() {
+		char character = peek();
+		if (character == '\"') {
+			readRawString();
+		} else if (character == '{' || character == '[') {
+			int depth = 0;
+			do {
+				character = peek();
+				if (character == '\"') {
+					readRawString();
+					continue;
+				}
+				m_pos++;
+				if (character == '{' || character == '[') depth++;
+				if (character == '}' || character == ']') depth--;
+			} while (depth > 0);
+		} else if (!consumeLiteral("true") && !consumeLiteral("false") && !consumeLiteral("null")) {
+			readNumber<double>();
+		}
+	}
+
+	/**
+	 * @brief check that nothing but whitespace follows the value that was read
+	 */
+	void finish() {
+		skipWhitespace();
+		if (m_pos != m_input.size()) throw invalid_argument("string is not a valid json");
+	}
+};
+
+/**
+ * @brief FNV-1a hash of a json key - evaluated at compile time for the keys declared in a struct mapping
+ */
+constexpr uint64_t hashJsonKey(string_view key) {
+	uint64_t hash = 14695981039346656037ull;
+	for (char character : key) {
+		hash ^= static_cast<unsigned char>(character);
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+/**
+ * @class JsonField
+ * description of one struct member and the json key it is stored under
+ */
+template<typename T, typename M>
+struct JsonField {
+	string_view key;
+	M T::* member;
+	uint64_t keyHash;
+
+	constexpr JsonField(string_view fieldKey, M T::* fieldMember) : key(fieldKey), member(fieldMember), keyHash(hashJsonKey(fieldKey)) {}
+};
+
+/**
+ * @class JsonFields
+ * traits listing the mapped fields of a struct - specialised for a user struct with SIMPLEJSON_MAPPING
+ */
+template<typename T>
+struct JsonFields {
+	static constexpr bool mapped = false;
+};
+
+/**
+ * @brief declare the json mapping of a struct, must be used at global scope
+ * e.g. SIMPLEJSON_MAPPING(Person, SIMPLEJSON_FIELD(name), SIMPLEJSON_FIELD_KEY(isRemote, "remote"))
+ */
+#define SIMPLEJSON_MAPPING(Type, ...) \
+	template<> struct JsonFields<Type> { \
+		using MappedType = Type; \
+		static constexpr bool mapped = true; \
+		static constexpr auto fields() { return std::make_tuple(__VA_ARGS__); } \
+	};
+
+/**
+ * @brief map a struct member to a json key of the same name
+ */
+#define SIMPLEJSON_FIELD(member) JsonField<MappedType, decltype(MappedType::member)>(#member, &MappedType::member)
+
+/**
+ * @brief map a struct member to a json key with a different name
+ */
+#define SIMPLEJSON_FIELD_KEY(member, key) JsonField<MappedType, decltype(MappedType::member)>(key, &MappedType::member)
+
+/**
+ * @class JsonMapper
+ * Deserialize json text directly into mapped structs, vectors and primitives (and serialize them back) without building an element tree
+ */
+class JsonMapper {
+public:
+	/**
+	 * @brief deserialize a json string into a new value of type T
+	 */
+	template<typename T>
+	static T parse(string_view input) {
+		T value{};
+		parse(input, value);
+		return value;
+	}
+
+	/**
+	 * @brief deserialize a json string into an existing value
+	 */
+	template<typename T>
+	static void parse(string_view input, T& value) {
+		JsonReader reader(input);
+		read(reader, value);
+		reader.finish();
+	}
+
+	/**
+	 * @brief serialize a value to a json string
+	 */
+	template<typename T>
+	static string serialize(const T& value) {
+		string output;
+		write(output, value);
+		return output;
+	}
+private:
+	template<typename T>
+	static constexpr bool isMappable() {
+		return is_arithmetic_v<T> || JsonFields<T>::mapped;
+	}
+
+	//----------------------------- READ ------------------------------//
+
+	static void read(JsonReader& reader, string& value) {
+		reader.readString(value);
+	}
+
+	static void read(JsonReader& reader, bool& value) {
+		value = reader.readBool();
+	}
+
+	template<typename T>
+	static void read(JsonReader& reader, vector<T>& value) {
+		value.clear();
+		reader.expect('[');
+		if (reader.consume(']')) return;
+		do {
+			T item{};
+			read(reader, item);
+			value.push_back(std::move(item));
+		} while (reader.consume(','));
+		reader.expect(']');
+	}
+
+	template<typename T>
+	static void read(JsonReader& reader, T& value) {
+		static_assert(isMappable<T>(), "type has no json mapping - declare one with SIMPLEJSON_MAPPING");
+		if constexpr (is_arithmetic_v<T>) {
+			value = reader.readNumber<T>();
+		} else {
+			readObject(reader, value);
+		}
+	}
+
+	/**
+	 * @brief read the members of a json object, dispatching each key to the matching struct member
+	 * keys that are not part of the mapping are skipped
+	 */
+	template<typename T>
+	static void readObject(JsonReader& reader, T& value) {
+		static constexpr auto s_fields = JsonFields<T>::fields();
+		reader.expect('{');
+		if (reader.consume('}')) return;
+		do {
+			string_view key = reader.readRawString();
+			string decodedKey;
+			if (key.find('\\') != string_view::npos) {
+				decodedKey.assign(key);
+				decodedKey.resize(unescapeJsonString(decodedKey.data(), decodedKey.size()));
+				key = decodedKey;
+			}
+			reader.expect(':');
+			if (!readField(reader, value, key, s_fields)) reader.skipValue();
+		} while (reader.consume(','));
+		reader.expect('}');
+	}
+
+	/**
+	 * @brief compare the key's hash against the compile time hash of each field, only comparing strings on a hash match
+	 */
+	template<typename T, typename Fields>
+	static bool readField(JsonReader& reader, T& value, string_view key, const Fields& fields) {
+		uint64_t keyHash = hashJsonKey(key);
+		return apply([&](const auto&... field) {
+			return ((field.keyHash == keyHash && field.key == key && (read(reader, value.*(field.member)), true)) || ...);
+		}, fields);
+	}
+
+	//----------------------------- WRITE ------------------------------//
+
+	static void write(string& output, const string& value) {
+		output.append("\"");
+		appendEscaped(output, value);
+		output.append("\"");
+	}
+
+	static void write(string& output, bool value) {
+		output.append(value ? "true" : "false");
+	}
+
+	template<typename T>
+	static void write(string& output, const vector<T>& value) {
+		output.append("[");
+		for (size_t i = 0; i < value.size(); i++) {
+			if (i) output.append(", ");
+			write(output, value[i]);
+		}
+		output.append("]");
+	}
+
+	template<typename T>
+	static void write(string& output, const T& value) {
+		static_assert(isMappable<T>(), "type has no json mapping - declare one with SIMPLEJSON_MAPPING");
+		if constexpr (is_arithmetic_v<T>) {
+			char buffer[32];
+			to_chars_result result = to_chars(buffer, buffer + sizeof(buffer), value);
+			output.append(buffer, result.ptr);
+		} else {
+			writeObject(output, value);
+		}
+	}
+
+	template<typename T>
+	static void writeObject(string& output, const T& value) {
+		static constexpr auto s_fields = JsonFields<T>::fields();
+		output.append("{");
+		bool first = true;
+		apply([&](const auto&... field) {
+			((output.append(first ? "\"" : ", \"").append(field.key).append("\": "), write(output, value.*(field.member)), first = false), ...);
+		}, s_fields);
+		output.append("}");
+	}
+};
+
+
+
+//----------------------------- STREAMING WRITER ------------------------------//
+
+/**
+ * @class JsonWriter
+ * Forward-only writer which emits json text straight to a string or a stream without building an element tree
+ * Strings are escaped the same way as serialize(), and floating point numbers are written with the shortest digits that read
+ * back as the same value of their own type, so 0.1f is written as 0.1. Unless NDEBUG is defined, calls that would produce invalid json
+ * throw std::invalid_argument
+ */
+class JsonWriter {
+private:
+	string m_buffer;	//output waiting to be written to the stream
+	string* m_pOutput;	//the caller's string, or m_buffer when writing to a stream
+	ostream* m_pStream = nullptr;
+	size_t m_bufferSize = 0;
+	bool m_needsComma = false;	//a value has been written and the next value or key must be separated from it
+#ifndef NDEBUG
+	vector<char> m_scopes;	//open bracket of each container still open
+	bool m_afterKey = false;	//a key has been written and its value has not
+	bool m_complete = false;	//a whole top level value has been written
+#endif
+
+	/**
+	 * @brief check a value may be written here and write the separator before it
+	 */
+	void beginValue() {
+#ifndef NDEBUG
+		if (m_scopes.empty() && m_complete) throw invalid_argument("json document already has a value");
+		if (!m_scopes.empty() && m_scopes.back() == '{' && !m_afterKey) throw invalid_argument("object member is missing a key");
+		m_afterKey = false;
+#endif
+		if (m_needsComma) m_pOutput->append(", ");
+	}
+
+	/**
+	 * @brief record that a value has been written and pass full buffers on to the stream
+	 */
+	void endValue() {
+		m_needsComma = true;
+#ifndef NDEBUG
+		if (m_scopes.empty()) m_complete = true;
+#endif
+		if (m_pStream && m_buffer.size() >= m_bufferSize) flush();
+	}
+
+	void beginContainer(char bracket) {
+		beginValue();
+		m_pOutput->push_back(bracket);
+		m_needsComma = false;
+#ifndef NDEBUG
+		m_scopes.push_back(bracket);
+#endif
+	}
+
+	void endContainer([[maybe_unused]] char openBracket, char closeBracket) {
+#ifndef NDEBUG
+		if (m_scopes.empty() || m_scopes.back() != openBracket) throw invalid_argument(string("no open ") + (openBracket == '{' ? "object" : "array") + " to close");
+		if (m_afterKey) throw invalid_argument("object member is missing a value");
+		m_scopes.pop_back();
+#endif
+		m_pOutput->push_back(closeBracket);
+		endValue();
+	}
+public:
+	/**
+	 * @brief constructor - append the json to a string
+	 */
+	JsonWriter(string& output) : m_pOutput(&output) {}
+
+	/**
+	 * @brief constructor - write the json to a stream, passing it on whenever bufferSize bytes are waiting
+	 */
+	JsonWriter(ostream& stream, size_t bufferSize = 1 << 16) : m_pOutput(&m_buffer), m_pStream(&stream), m_bufferSize(bufferSize) {
+		m_buffer.reserve(bufferSize);
+	}
+
+	/**
+	 * @brief destructor - write anything still buffered to the stream
+	 */
+	~JsonWriter() {
+		flush();
+	}
+
+	JsonWriter(const JsonWriter&) = delete;
+	JsonWriter& operator=(const JsonWriter&) = delete;
+
+	JsonWriter& beginObject() {
+		beginContainer('{');
+		return *this;
+	}
+
+	JsonWriter& endObject() {
+		endContainer('{', '}');
+		return *this;
+	}
+
+	JsonWriter& beginArray() {
+		beginContainer('[');
+		return *this;
+	}
+
+	JsonWriter& endArray() {
+		endContainer('[', ']');
+		return *this;
+	}
+
+	/**
+	 * @brief write the key of the next object member
+	 */
+	JsonWriter& key(string_view key) {
+#ifndef NDEBUG
+		if (m_scopes.empty() || m_scopes.back() != '{' || m_afterKey) throw invalid_argument("keys can only be written inside an object, once before each value");
+		m_afterKey = true;
+#endif
+		if (m_needsComma) m_pOutput->append(", ");
+		m_pOutput->push_back('\"');
+		appendEscaped(*m_pOutput, key);
+		m_pOutput->append("\": ");
+		m_needsComma = false;
+		return *this;
+	}
+
+	JsonWriter& value(string_view value) {
+		beginValue();
+		m_pOutput->push_back('\"');
+		appendEscaped(*m_pOutput, value);
+		m_pOutput->push_back('\"');
+		endValue();
+		return *this;
+	}
+
+	/**
+	 * @brief write a string value - without this overload string literals would be written as bools
+	 */
+	JsonWriter& value(const char* value) {
+		return this->value(string_view(value));
+	}
+
+	/**
+	 * @brief write a bool or a number - integers are written exactly and floating point numbers must be finite
+	 */
+	template<typename T>
+	enable_if_t<is_arithmetic_v<T>, JsonWriter&> value(T value) {
+		if constexpr (is_floating_point_v<T>) {
+			if (!isfinite(value)) throw invalid_argument("json numbers must be finite");
+		}
+		beginValue();
+		if constexpr (is_same_v<T, bool>) {
+			m_pOutput->append(value ? "true" : "false");
+		} else {
+			char buffer[64];	//fits the shortest form of any long double
+			to_chars_result result = to_chars(buffer, buffer + sizeof(buffer), value);
+			m_pOutput->append(buffer, result.ptr);
+		}
+		endValue();
+		return *this;
+	}
+
+	JsonWriter& null() {
+		beginValue();
+		m_pOutput->append("null");
+		endValue();
+		return *this;
+	}
+
+	/**
+	 * @brief write a value that is already json text, such as the output of serialize(), without checking it
+	 */
+	JsonWriter& rawValue(string_view json) {
+		beginValue();
+		m_pOutput->append(json);
+		endValue();
+		return *this;
+	}
+
+	/**
+	 * @brief write anything buffered to the stream
+	 */
+	void flush() {
+		if (!m_pStream || m_buffer.empty()) return;
+		m_pStream->write(m_buffer.data(), m_buffer.size());
+		m_buffer.clear();
+	}
+
+	/**
+	 * @brief check whether a whole top level value has been written and every container closed - always true if NDEBUG is defined
+	 */
+	bool isComplete() const {
+#ifndef NDEBUG
+		return m_complete;
+#else
+		return true;
+#endif
+	}
+};
+
+
+
+//----------------------------- COMPILE TIME JSON ------------------------------//
+
+/**
+ * @class StaticElement
+ * Read-only element of a json document parsed at compile time or frozen from a SimpleJson. Keys and values are stored decoded in the
+ * document's text and found by offset, so a document holds no pointers into itself and can be copied. Elements are stored in a flat
+ * array and linked by index rather than by pointer
+ */
+struct StaticElement {
+	enum valueType {
+		EMPTY,
+		STRING,
+		BOOL,
+		NUMBER,
+		OBJECT,
+		ARRAY
+	};
+	static constexpr size_t npos = static_cast<size_t>(-1);
+
+	size_t keyOffset = 0;
+	size_t keySize = 0;
+	size_t valueOffset = 0;
+	size_t valueSize = 0;
+	valueType type = EMPTY;
+	size_t childIndex = npos;
+	size_t nextIndex = npos;
+	size_t childCount = 0;
+};
+
+/**
+ * @class StaticJsonParser
+ * constexpr recursive descent parser which fills a flat array of StaticElements and the text holding their decoded keys and values
+ * any syntax error throws, which fails the build when the parser is evaluated at compile time
+ */
+class StaticJsonParser {
+private:
+	string_view m_input;
+	size_t m_pos = 0;
+	StaticElement* m_pElements = nullptr;
+	char* m_pText = nullptr;
+	size_t m_textCapacity = 0;
+	bool m_countOnly = true;	//first pass only counts the elements and text so the arrays can be sized
+	size_t m_count = 0;
+	size_t m_textSize = 0;
+
+	constexpr void skipWhitespace() {
+		while (m_pos < m_input.size() && (m_input[m_pos] == ' ' || m_input[m_pos] == '\n' || m_input[m_pos] == '\r' || m_input[m_pos] == '\t')) m_pos++;
+	}
+
+	constexpr char peek() {
+		skipWhitespace();
+		if (m_pos >= m_input.size()) throw invalid_argument("string is not a valid json");
+		return m_input[m_pos];
+	}
+
+	constexpr bool consume(char character) {
+		if (peek() != character) return false;
+		m_pos++;
+		return true;
+	}
+
+	constexpr void expect(char character) {
+		if (!consume(character)) throw invalid_argument("string is not a valid json");
+	}
+
+	constexpr bool isDigit() const {
+		return m_pos < m_input.size() && m_input[m_pos] >= '0' && m_input[m_pos] <= '9';
+	}
+
+	constexpr void expectDigits() {
+		if (!isDigit()) throw invalid_argument("tried to set an invalid json value");
+		while (isDigit()) m_pos++;
+	}
+
+	/**
+	 * @brief read a quoted string and return a view of its contents without the surrounding quotes
+	 */
+	constexpr string_view readString() {
+		expect('\"');
+		size_t start = m_pos;
+		while (m_pos < m_input.size()) {
+			char character = m_input[m_pos++];
+			if (character == '\\') {
+				m_pos++;
+			} else if (character == '\"') {
+				return m_input.substr(start, m_pos-1-start);
+			}
+		}
+		throw invalid_argument("string is not a valid json");
+	}
+
+	/**
+	 * @brief read a number, checking it against the json number grammar
+	 */
+	constexpr string_view readNumber() {
+		size_t start = m_pos;
+		if (m_input[m_pos] == '-') m_pos++;
+		if (m_pos < m_input.size() && m_input[m_pos] == '0') {
+			m_pos++;	//json does not allow leading zeros
+		} else {
+			expectDigits();
+		}
+		if (m_pos < m_input.size() && m_input[m_pos] == '.') {
+			m_pos++;
+			expectDigits();
+		}
+		if (m_pos < m_input.size() && (m_input[m_pos] == 'e' || m_input[m_pos] == 'E')) {
+			m_pos++;
+			if (m_pos < m_input.size() && (m_input[m_pos] == '+' || m_input[m_pos] == '-')) m_pos++;
+			expectDigits();
+		}
+		return m_input.substr(start, m_pos-start);
+	}
+
+	constexpr string_view readLiteral(string_view literal) {
+		if (m_input.substr(m_pos, literal.size()) != literal) throw invalid_argument("tried to set an invalid json value");
+		m_pos += literal.size();
+		return literal;
+	}
+
+	/**
+	 * @brief append a key or value to the text, decoding the escape sequences of a string, and return its size
+	 * when only counting the raw size is returned, which is never less than the decoded size
+	 */
+	constexpr size_t addText(string_view raw, bool isString) {
+		if (m_countOnly) {
+			m_textSize += raw.size();
+			return raw.size();
+		}
+		if (m_textSize + raw.size() > m_textCapacity) throw invalid_argument("static json text buffer is too small");
+		size_t start = m_textSize;
+		for (size_t in = 0; in < raw.size();) {
+			if (isString && raw[in] == '\\') {
+				m_textSize += decodeJsonEscape(raw, in, m_pText + m_textSize);
+			} else {
+				m_pText[m_textSize++] = raw[in++];
+			}
+		}
+		return m_textSize - start;
+	}
+
+	/**
+	 * @brief reserve the next element in the array - when only counting elements nothing is written
+	 */
+	constexpr size_t addElement(string_view key, StaticElement::valueType type, string_view value = string_view()) {
+		size_t index = m_count++;
+		size_t keyOffset = m_textSize;
+		size_t keySize = addText(key, true);
+		size_t valueOffset = m_textSize;
+		size_t valueSize = addText(value, type == StaticElement::STRING);
+		if (!m_countOnly) {
+			m_pElements[index].keyOffset = keyOffset;
+			m_pElements[index].keySize = keySize;
+			m_pElements[index].type = type;
+			m_pElements[index].valueOffset = valueOffset;
+			m_pElements[index].valueSize = valueSize;
+		}
+		return index;
+	}
+
+	/**
+	 * @brief append a child to a parent element, linking it to the previous sibling
+	 */
+	constexpr void linkChild(size_t parentIndex, size_t prevIndex, size_t childIndex) {
+		if (m_countOnly) return;
+		if (prevIndex == StaticElement::npos) {
+			m_pElements[parentIndex].childIndex = childIndex;
+		} else {
+			m_pElements[prevIndex].nextIndex = childIndex;
+		}
+		m_pElements[parentIndex].childCount++;
+	}
+
+	constexpr size_t parseValue(string_view key) {
+		switch (peek()) {
+			case '{':
+				return parseContainer(key, StaticElement::OBJECT, '}');
+			case '[':
+				return parseContainer(key, StaticElement::ARRAY, ']');
+			case '\"':
+				return addElement(key, StaticElement::STRING, readString());
+			case 't':
+				return addElement(key, StaticElement::BOOL, readLiteral("true"));
+			case 'f':
+				return addElement(key, StaticElement::BOOL, readLiteral("false"));
+			case 'n':
+				return addElement(key, StaticElement::EMPTY, readLiteral("null"));
+			default:
+				return addElement(key, StaticElement::NUMBER, readNumber());
+		}
+	}
+
+	constexpr size_t parseContainer(string_view key, StaticElement::valueType type, char closeBracket) {
+		m_pos++;
+		size_t index = addElement(key, type);
+		if (consume(closeBracket)) return index;
+		size_t prevIndex = StaticElement::npos;
+		do {
+			string_view childKey;
+			if (type == StaticElement::OBJECT) {
+				childKey = readString();
+				expect(':');
+			}
+			size_t childIndex = parseValue(childKey);
+			linkChild(index, prevIndex, childIndex);
+			prevIndex = childIndex;
+		} while (consume(','));
+		expect(closeBracket);
+		return index;
+	}
+public:
+	constexpr StaticJsonParser(string_view input) : m_input(input) {}
+
+	constexpr StaticJsonParser(string_view input, StaticElement* pElements, char* pText, size_t textCapacity) : m_input(input), m_pElements(pElements), m_pText(pText), m_textCapacity(textCapacity), m_countOnly(false) {}
+
+	/**
+	 * @brief parse the whole input, returning the number of elements
+	 */
+	constexpr size_t parse() {
+		parseValue(string_view());
+		skipWhitespace();
+		if (m_pos != m_input.size()) throw invalid_argument("string is not a valid json");
+		return m_count;
+	}
+
+	/**
+	 * @brief count the elements in a json string so the document array can be sized at compile time
+	 */
+	static constexpr size_t countElements(string_view input) {
+		return StaticJsonParser(input).parse();
+	}
+
+	/**
+	 * @brief count the bytes of text needed to hold the keys and values of a json string
+	 */
+	static constexpr size_t countText(string_view input) {
+		StaticJsonParser parser(input);
+		parser.parse();
+		return parser.m_textSize;
+	}
+};
+
+/**
+ * @class StaticJsonView
+ * read-only handle to one element of a StaticJson or FrozenJson document, with the same get methods as SimpleJson
+ */
+class StaticJsonView {
+private:
+	const StaticElement* m_pElements;
+	const char* m_pText;
+	size_t m_index;
+
+	constexpr const StaticElement& element() const {
+		return m_pElements[m_index];
+	}
+
+	constexpr string_view key(const StaticElement& element) const {
+		return string_view(m_pText + element.keyOffset, element.keySize);
+	}
+
+	constexpr string_view value() const {
+		return string_view(m_pText + element().valueOffset, element().valueSize);
+	}
+
+	static constexpr bool isDigit(char character) {
+		return character >= '0' && character <= '9';
+	}
+public:
+	constexpr StaticJsonView(const StaticElement* pElements, const char* pText, size_t index) : m_pElements(pElements), m_pText(pText), m_index(index) {}
+
+	/**
+	 * @brief get json value by key from the top layer of this element
+	 */
+	constexpr StaticJsonView get(string_view key) const {
+		if (element().type == StaticElement::ARRAY) throw invalid_argument("cannot get an array by key");
+		for (size_t index = element().childIndex; index != StaticElement::npos; index = m_pElements[index].nextIndex) {
+			if (this->key(m_pElements[index]) == key) return StaticJsonView(m_pElements, m_pText, index);
+		}
+		throw invalid_argument("could not find this key");
+	}
+
+	/**
+	 * @brief get json value by index from the top layer of this element
+	 */
+	constexpr StaticJsonView get(int index) const {
+		if (element().type == StaticElement::OBJECT) throw invalid_argument("cannot get an object by index");
+		size_t current = element().childIndex;
+		for (int i = 0; i < index && current != StaticElement::npos; i++) current = m_pElements[current].nextIndex;
+		if (index < 0 || current == StaticElement::npos) throw invalid_argument("could not find this index");
+		return StaticJsonView(m_pElements, m_pText, current);
+	}
+
+	/**
+	 * @brief return the number of children of an object or array
+	 */
+	constexpr size_t size() const {
+		return element().childCount;
+	}
+
+	constexpr bool isBool() const {
+		return element().type == StaticElement::BOOL;
+	}
+
+	constexpr bool getBool() const {
+		if (!isBool()) throw invalid_argument("element is not a bool");
+		return value() == "true";
+	}
+
+	constexpr bool isString() const {
+		return element().type == StaticElement::STRING;
+	}
+
+	/**
+	 * @brief return a view of the string value, with its escape sequences decoded
+	 */
+	constexpr string_view getString() const {
+		if (!isString()) throw invalid_argument("element is not a string");
+		return value();
+	}
+
+	constexpr bool isFloat() const {
+		return element().type == StaticElement::NUMBER;
+	}
+
+	/**
+	 * @brief convert the number text to a float. The text has already been checked against the json grammar by the parser
+	 */
+	constexpr float getFloat() const {
+		if (!isFloat()) throw invalid_argument("element is not a number");
+		string_view text = value();
+		size_t pos = 0;
+		double sign = 1;
+		if (text[pos] == '-') {
+			sign = -1;
+			pos++;
+		}
+		double mantissa = 0;
+		int exponent = 0;
+		for (; pos < text.size() && isDigit(text[pos]); pos++) mantissa = mantissa*10 + (text[pos]-'0');
+		if (pos < text.size() && text[pos] == '.') {
+			for (pos++; pos < text.size() && isDigit(text[pos]); pos++) {
+				mantissa = mantissa*10 + (text[pos]-'0');
+				exponent--;
+			}
+		}
+		if (pos < text.size()) {
+			pos++;	//skip 'e'
+			int exponentSign = 1;
+			if (text[pos] == '+' || text[pos] == '-') exponentSign = text[pos++] == '-' ? -1 : 1;
+			int explicitExponent = 0;
+			for (; pos < text.size(); pos++) explicitExponent = explicitExponent*10 + (text[pos]-'0');
+			exponent += exponentSign*explicitExponent;
+		}
+		for (; exponent > 0; exponent--) mantissa *= 10;
+		for (; exponent < 0; exponent++) mantissa /= 10;
+		return static_cast<float>(sign*mantissa);
+	}
+};
+
+/**
+ * @class StaticJson
+ * json document parsed at compile time into fixed size arrays - construct with SIMPLEJSON_STATIC so the sizes are deduced from the literal
+ * a constexpr StaticJson costs no heap allocation and no startup time, and malformed literals fail the build
+ */
+template<size_t N, size_t TextSize>
+class StaticJson {
+private:
+	StaticElement m_elements[N] {};
+	char m_text[TextSize ? TextSize : 1] {};
+public:
+	constexpr StaticJson(string_view input) {
+		StaticJsonParser(input, m_elements, m_text, TextSize).parse();
+	}
+
+	/**
+	 * @brief return a view of the first element of the document
+	 */
+	constexpr StaticJsonView root() const {
+		return StaticJsonView(m_elements, m_text, 0);
+	}
+
+	constexpr StaticJsonView get(string_view key) const {
+		return root().get(key);
+	}
+
+	constexpr StaticJsonView get(int index) const {
+		return root().get(index);
+	}
+};
+
+/**
+ * @brief parse a json string literal at compile time, e.g. constexpr auto defaults = SIMPLEJSON_STATIC(R"({"retries": 3})");
+ */
+#define SIMPLEJSON_STATIC(literal) StaticJson<StaticJsonParser::countElements(literal), StaticJsonParser::countText(literal)>(literal)
+
+
+
+
+//----------------------------- FROZEN JSON ------------------------------//
+
+/**
+ * @class FrozenJson
+ * Immutable snapshot of a SimpleJson document created by SimpleJson::freeze()
+ * Elements are stored in a flat array using the same StaticElement layout as compile time documents, with keys and values held in one string
+ * Reads go through StaticJsonView, which never mutates or allocates, so a FrozenJson can be shared between threads without locking
+ */
+class FrozenJson {
+friend class SimpleJson;
+private:
+	string m_text;
+	vector<StaticElement> m_elements;
+
+	/**
+	 * @brief convert an element's value type to the matching static type
+	 */
+	static StaticElement::valueType staticType(int valueType) {
+		switch (valueType) {
+			case Element::STRING:
+				return StaticElement::STRING;
+			case Element::BOOL:
+				return StaticElement::BOOL;
+			case Element::NUMBER:
+				return StaticElement::NUMBER;
+			case Element::OBJECT:
+				return StaticElement::OBJECT;
+			case Element::ARRAY:
+				return StaticElement::ARRAY;
+			default:
+				return StaticElement::EMPTY;
+		}
+	}
+
+	/**
+	 * @brief copy an element tree, given in tree order, into the flat array
+	 * the placeholder the parser leaves in an empty array or object is dropped, so the container has no children
+	 */
+	FrozenJson(vector<Element*> order) {
+		order.erase(remove_if(order.begin(), order.end(), [](const Element* pElement) { return pElement->isPlaceholder(); }), order.end());
+		m_elements.resize(order.size());
+		unordered_map<const Element*, size_t> indexOf;
+		size_t textSize = 0;
+		for (size_t i = 0; i < order.size(); i++) {
+			indexOf[order[i]] = i;
+			textSize += order[i]->getKeyRaw().size() + order[i]->m_value.size();
+		}
+		m_text.reserve(textSize);
+		for (size_t i = 0; i < order.size(); i++) {
+			const Element& element = *order[i];
+			StaticElement& frozen = m_elements[i];
+			frozen.type = staticType(element.m_valueType);
+			frozen.keyOffset = appendText(element.getKeyRaw());
+			frozen.keySize = element.getKeyRaw().size();
+			frozen.valueOffset = m_text.size();
+			if (element.m_valueType != Element::OBJECT && element.m_valueType != Element::ARRAY) {	//a container's value may hold its hash
+				appendText(element.m_value.view());
+				frozen.valueSize = element.m_value.size();
+			}
+			if (element.m_pNextElement) frozen.nextIndex = indexOf[element.m_pNextElement];
+			if (element.m_pChildElement && !element.m_pChildElement->isPlaceholder() && (element.m_valueType == Element::OBJECT || element.m_valueType == Element::ARRAY)) {
+				frozen.childIndex = indexOf[element.m_pChildElement];
+				for (Element* pChild = element.m_pChildElement; pChild; pChild = pChild->m_pNextElement) frozen.childCount++;
+			}
+		}
+	}
+
+	/**
+	 * @brief append a key or value to the text, returning its offset
+	 */
+	size_t appendText(string_view text) {
+		size_t offset = m_text.size();
+		m_text.append(text);
+		return offset;
+	}
+public:
+	FrozenJson(const FrozenJson&) = delete;
+	FrozenJson& operator=(const FrozenJson&) = delete;
+
+	/**
+	 * @brief return a view of the first element of the document
+	 */
+	StaticJsonView root() const {
+		return StaticJsonView(m_elements.data(), m_text.data(), 0);
+	}
+
+	StaticJsonView get(string_view key) const {
+		return root().get(key);
+	}
+
+	StaticJsonView get(int index) const {
+		return root().get(index);
+	}
+};
+
+inline shared_ptr<const FrozenJson> SimpleJson::freeze() {
+	return shared_ptr<const FrozenJson>(new FrozenJson(elementsInTreeOrder()));
+}
+
+/**
+ * @class FrozenJsonHolder
+ * RCU-style holder for hot reloading a shared FrozenJson. Readers load() a snapshot which stays valid for as long as they hold it,
+ * while a writer parses and freezes the replacement off to the side and then store()s it
+ * load() and store() use the atomic shared_ptr functions, which are not lock-free in common standard libraries (libstdc++ takes a
+ * mutex from a small pool): readers and the writer serialize briefly on the pointer copy, but never wait for a parse or a freeze
+ */
+class FrozenJsonHolder {
+private:
+	shared_ptr<const FrozenJson> m_pDocument;
+public:
+	FrozenJsonHolder(shared_ptr<const FrozenJson> pDocument = nullptr) : m_pDocument(std::move(pDocument)) {}
+
+	/**
+	 * @brief take a snapshot of the current document
+	 */
+	shared_ptr<const FrozenJson> load() const {
+		return atomic_load(&m_pDocument);
+	}
+
+	/**
+	 * @brief publish a new document - the previous one is released when its last reader drops it
+	 */
+	void store(shared_ptr<const FrozenJson> pDocument) {
+		atomic_store(&m_pDocument, std::move(pDocument));
+	}
+};
+
+//----------------------------- ASYNC LOADING ------------------------------//
+
+/**
+ * @class JsonFileLoader
+ * loads many json files with disk reads and parsing overlapped: an io thread reads each file in fixed size blocks while a parse thread
+ * deserializes the files already read. Read files wait in a queue bounded by size, so a slow parser stalls the reader rather than filling memory
+ * the parser needs a whole document, so reading and parsing overlap across files rather than within one
+ */
+class JsonFileLoader {
+private:
+	struct Job {
+		string path;
+		string contents;
+		promise<unique_ptr<SimpleJson>> result;
+	};
+
+	JsonOptions m_options;
+	size_t m_blockSize;
+	size_t m_maxQueuedBytes;
+	mutex m_mutex;
+	condition_variable m_changed;
+	deque<Job> m_pendingJobs;	//waiting to be read
+	deque<Job> m_readJobs;		//read and waiting to be parsed
+	size_t m_queuedBytes = 0;	//bytes read but not yet handed to the parser
+	bool m_stopping = false;
+	bool m_readingDone = false;
+	thread m_ioThread;
+	thread m_parseThread;
+
+	/**
+	 * @brief io thread - read each pending file block by block, waiting whenever the read queue is full
+	 */
+	void readFiles() {
+		vector<char> block(m_blockSize);
+		unique_lock<mutex> lock(m_mutex);
+		while (true) {
+			m_changed.wait(lock, [this] { return m_stopping || !m_pendingJobs.empty(); });
+			if (m_pendingJobs.empty()) break;
+			Job job = std::move(m_pendingJobs.front());
+			m_pendingJobs.pop_front();
+			lock.unlock();
+			ifstream stream(job.path, ios::binary);
+			if (!stream) {
+				job.result.set_exception(make_exception_ptr(invalid_argument("could not open file " + job.path)));
+				lock.lock();
+				continue;
+			}
+			stream.seekg(0, ios::end);
+			job.contents.reserve(static_cast<size_t>(max<streamoff>(stream.tellg(), 0)));
+			stream.seekg(0, ios::beg);
+			while (stream) {
+				stream.read(block.data(), block.size());
+				job.contents.append(block.data(), static_cast<size_t>(stream.gcount()));
+				lock.lock();
+				m_queuedBytes += static_cast<size_t>(stream.gcount());
+				//an oversized file may still go through on its own, otherwise wait for the parser to catch up
+				m_changed.wait(lock, [this] { return m_queuedBytes <= m_maxQueuedBytes || m_readJobs.empty(); });
+				lock.unlock();
+			}
+			lock.lock();
+			m_readJobs.push_back(std::move(job));
+			m_changed.notify_all();
+		}
+		m_readingDone = true;
+		m_changed.notify_all();
+	}
+
+	/**
+	 * @brief parse thread - deserialize each file as soon as it has been read
+	 */
+	void parseFiles() {
+		unique_lock<mutex> lock(m_mutex);
+		while (true) {
+			m_changed.wait(lock, [this] { return m_readingDone || !m_readJobs.empty(); });
+			if (m_readJobs.empty()) break;
+			Job job = std::move(m_readJobs.front());
+			m_readJobs.pop_front();
+			m_queuedBytes -= job.contents.size();
+			m_changed.notify_all();
+			lock.unlock();
+			try {
+				job.result.set_value(make_unique<SimpleJson>(std::move(job.contents), m_options));
+			} catch (...) {
+				job.result.set_exception(current_exception());
+			}
+			lock.lock();
+		}
+	}
+public:
+	/**
+	 * @brief start the io and parse threads
+	 * @param blockSize - bytes read from disk at a time
+	 * @param maxQueuedBytes - bytes that may be read ahead of the parser
+	 */
+	JsonFileLoader(JsonOptions options = JsonOptions(), size_t blockSize = 1 << 20, size_t maxQueuedBytes = 64 << 20) : m_options(options), m_blockSize(max<size_t>(blockSize, 1)), m_maxQueuedBytes(maxQueuedBytes) {
+		m_ioThread = thread(&JsonFileLoader::readFiles, this);
+		m_parseThread = thread(&JsonFileLoader::parseFiles, this);
+	}
+
+	/**
+	 * @brief finish loading every file already requested, then stop the threads
+	 */
+	~JsonFileLoader() {
+		{
+			lock_guard<mutex> lock(m_mutex);
+			m_stopping = true;
+		}
+		m_changed.notify_all();
+		m_ioThread.join();
+		m_parseThread.join();
+	}
+
+	JsonFileLoader(const JsonFileLoader&) = delete;
+	JsonFileLoader& operator=(const JsonFileLoader&) = delete;
+
+	/**
+	 * @brief queue a file to be loaded - the future holds the parsed document, or the exception thrown opening or parsing it
+	 */
+	future<unique_ptr<SimpleJson>> load(const string& path) {
+		Job job;
+		job.path = path;
+		future<unique_ptr<SimpleJson>> result = job.result.get_future();
+		{
+			lock_guard<mutex> lock(m_mutex);
+			if (m_stopping) throw invalid_argument("loader is stopping");
+			m_pendingJobs.push_back(std::move(job));
+		}
+		m_changed.notify_all();
+		return result;
+	}
+};
@@ -0,0 +1,65 @@
+#define SIMPLEJSON_STATS
+#include <gtest/gtest.h>
+#include "./../../include/SimpleJson.hpp"
+
+//instrumented build of the library, kept in its own executable as defining SIMPLEJSON_STATS changes the library's classes
+
+string validExample = "{\"person\": {\"name\": \"charlie\", \"skills\": true, \"age\": 27}}";
+string validExampleBasic = "{\"name\": \"charlie\", \"skills\": true, \"age\": 27}";
+string validArrayExample = "{\"name\": \"charlie\", \"skills\": [5, \"drawing\", false], \"drives\": \"yes\"}";
+
+TEST(stats, parseCountsElements) {
+	JsonStats stats;
+	{
+		JsonStats::Scope scope(stats);
+		SimpleJson testJson = SimpleJson(validArrayExample);
+	}
+	EXPECT_EQ(validArrayExample.size(), stats.bytesParsed);
+	EXPECT_EQ(1, stats.objects);
+	EXPECT_EQ(1, stats.arrays);
+	EXPECT_EQ(3, stats.strings);
+	EXPECT_EQ(1, stats.bools);
+	EXPECT_EQ(1, stats.numbers);
+	EXPECT_EQ(2, stats.maxDepth);
+	EXPECT_LT(0, stats.allocations);
+}
+
+TEST(stats, lookupsCountSteps) {
+	SimpleJson testJson = SimpleJson(validExampleBasic);
+	JsonStats stats;
+	{
+		JsonStats::Scope scope(stats);
+		testJson.get("age");
+	}
+	EXPECT_EQ(1, stats.lookups);
+	EXPECT_EQ(3, stats.lookupSteps);
+	EXPECT_EQ(0, stats.bytesParsed);
+	EXPECT_EQ(2, stats.bytesSerialized);
+}
+
+TEST(stats, notCollectedOutsideScope) {
+	JsonStats stats;
+	{
+		JsonStats::Scope scope(stats);
+	}
+	SimpleJson testJson = SimpleJson(validExample);
+	testJson.serialize();
+	EXPECT_EQ(0, stats.bytesParsed);
+	EXPECT_EQ(0, stats.bytesSerialized);
+}
+
+TEST(stats, countsEveryAllocation) {
+	string longValue(1000, 'x');
+	JsonStats stats;
+	{
+		JsonStats::Scope scope(stats);
+		SimpleJson testJson = SimpleJson("{\"name\": \"" + longValue + "\"}");
+	}
+	EXPECT_LT(3 * longValue.size(), stats.allocatedBytes);	//the retained copies of the input and the element's string, not just the elements
+}
+
+int main(int argc, char** argv) {
+	::testing::InitGoogleTest(&argc, argv);
+	RUN_ALL_TESTS();
+	return 0;
+}
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <thread>
 #include "./../../include/SimpleJson.hpp"
 
 string validExample = "{\"person\": {\"name\": \"charlie\", \"skills\": true, \"age\": 27}}";
@@ -13,6 +14,42 @@ string validArrayExample = "{\"name\": \"charlie\", \"skills\": [5, \"drawing\",
 string validArrayExampleBasic = "[5, \"drawing\", false]";
 string basicArraySetString = "[5, \"coding\", false]";
 string invalidExample = "{\"person\": {\"name\": \"charlie\", \"skills\": true, \"age\": 27}}}";
+string mappingExample = "{\"name\": \"charlie\", \"age\": 27, \"remote\": true, \"skills\": [{\"name\": \"drawing\", \"level\": 2.5}, {\"name\": \"coding\", \"level\": 4}]}";
+
+struct Skill {
+	string name;
+	float level;
+};
+SIMPLEJSON_MAPPING(Skill, SIMPLEJSON_FIELD(name), SIMPLEJSON_FIELD(level))
+
+struct Person {
+	string name;
+	int age;
+	bool isRemote;
+	vector<Skill> skills;
+};
+SIMPLEJSON_MAPPING(Person, SIMPLEJSON_FIELD(name), SIMPLEJSON_FIELD(age), SIMPLEJSON_FIELD_KEY(isRemote, "remote"), SIMPLEJSON_FIELD(skills))
+
+class CountingResource : public pmr::memory_resource {
+public:
+	size_t allocations = 0;
+	size_t outstandingBytes = 0;
+private:
+	void* do_allocate(size_t bytes, size_t alignment) override {
+		allocations++;
+		outstandingBytes += bytes;
+		return pmr::new_delete_resource()->allocate(bytes, alignment);
+	}
+
+	void do_deallocate(void* pMemory, size_t bytes, size_t alignment) override {
+		outstandingBytes -= bytes;
+		pmr::new_delete_resource()->deallocate(pMemory, bytes, alignment);
+	}
+
+	bool do_is_equal(const pmr::memory_resource& other) const noexcept override {
+		return this == &other;
+	}
+};
 
 void removeWhitespace(string& str) {
 	str.erase(remove(str.begin(), str.end(), ' '), str.end());
@@ -35,6 +72,37 @@ TEST(constructor, throwsIfInvalidJsonString) {
 	}, invalid_argument);
 }
 
+TEST(constructor, throwsIfNotJsonNumber) {
+	EXPECT_THROW({
+		SimpleJson testJson = SimpleJson("[-inf, 1]");
+	}, invalid_argument);
+	EXPECT_THROW({
+		SimpleJson testJson = SimpleJson("{\"value\": nan}");
+	}, invalid_argument);
+	EXPECT_THROW({
+		SimpleJson testJson = SimpleJson("[-infinity]");
+	}, invalid_argument);
+	EXPECT_EQ("[-0.5, 1e-3]", SimpleJson("[-0.5, 1e-3]").serialize());
+}
+
+static_assert(is_move_constructible_v<SimpleJson>, "a SimpleJson should be movable");
+
+SimpleJson parseAndReturn(const string& input) {
+	SimpleJson testJson(input);
+	testJson.key("name").setString("alex");
+	return testJson;
+}
+
+TEST(constructor, movesDocument) {
+	SimpleJson testJson = parseAndReturn(validExampleBasic);
+	EXPECT_EQ("alex", testJson.get("name").getString());
+	unique_ptr<SimpleJson> pSkills = make_unique<SimpleJson>(SimpleJson(validArrayExample).get("skills"));
+	EXPECT_EQ("drawing", pSkills->get(1).getString());
+	SimpleJson moved(std::move(testJson));
+	moved.reparse(validArrayExample);
+	EXPECT_EQ("charlie", moved.get("name").getString());
+}
+
 TEST(constructor, succeedsIfValidJsonFile) {
 	try {
 		ifstream stream("./../examples/small-valid.json");
@@ -130,6 +198,13 @@ TEST(get, getObjectByIndex) {
 	EXPECT_EQ(input, output);
 }
 
+TEST(get, getArrayOfObjects) {
+	SimpleJson testJson = SimpleJson(mappingExample);
+	SimpleJson skills = testJson.get("skills");	//nested objects followed by siblings must all be copied
+	EXPECT_EQ("[{\"name\": \"drawing\", \"level\": 2.5}, {\"name\": \"coding\", \"level\": 4}]", skills.serialize());
+	EXPECT_EQ("coding", skills.get(1).get("name").getString());
+}
+
 TEST(get, isStringTrue) {
 	SimpleJson testJson = SimpleJson(validExample);
 	SimpleJson person = testJson.get("person");
@@ -260,6 +335,712 @@ TEST(set, setFloatByIndex) {
 	EXPECT_EQ(56, output);
 }
 
+TEST(mapping, parseIntoStruct) {
+	Person person = JsonMapper::parse<Person>(mappingExample);
+	EXPECT_EQ("charlie", person.name);
+	EXPECT_EQ(27, person.age);
+	EXPECT_EQ(true, person.isRemote);
+	ASSERT_EQ(2, person.skills.size());
+	EXPECT_EQ("coding", person.skills[1].name);
+	EXPECT_EQ(2.5, person.skills[0].level);
+}
+
+TEST(mapping, parseSkipsUnknownKeys) {
+	Person person = JsonMapper::parse<Person>("{\"city\": {\"name\": \"london\", \"zones\": [1, 2]}, \"name\": \"charlie\"}");
+	EXPECT_EQ("charlie", person.name);
+}
+
+TEST(mapping, parseThrowsIfInvalid) {
+	EXPECT_THROW({
+		JsonMapper::parse<Person>("{\"name\": \"charlie\", \"age\": \"27\"}");
+	}, invalid_argument);
+	EXPECT_THROW({
+		JsonMapper::parse<Person>("{\"name\": \"charlie\"}}");
+	}, invalid_argument);
+}
+
+TEST(mapping, serializeStruct) {
+	Person person = JsonMapper::parse<Person>(mappingExample);
+	string input = mappingExample;
+	removeWhitespace(input);
+	string output = JsonMapper::serialize(person);
+	removeWhitespace(output);
+	EXPECT_EQ(input, output);
+}
+
+constexpr auto staticExample = SIMPLEJSON_STATIC("{\"person\": {\"name\": \"charlie\", \"skills\": [5, \"drawing\", false], \"age\": 27.5}}");
+static_assert(staticExample.get("person").get("age").getFloat() == 27.5f, "static json should be readable at compile time");
+
+TEST(staticJson, getValues) {
+	StaticJsonView person = staticExample.get("person");
+	EXPECT_EQ("charlie", person.get("name").getString());
+	EXPECT_EQ(true, person.get("skills").get(1).isString());
+	EXPECT_EQ(false, person.get("skills").get(2).getBool());
+	EXPECT_EQ(5, person.get("skills").get(0).getFloat());
+	EXPECT_EQ(3, person.get("skills").size());
+}
+
+TEST(staticJson, getThrowsIfMissing) {
+	EXPECT_THROW({
+		staticExample.get("person").get("city");
+	}, invalid_argument);
+	EXPECT_THROW({
+		staticExample.get("person").get("skills").get(3);
+	}, invalid_argument);
+}
+
+constexpr auto staticEscapes = SIMPLEJSON_STATIC("{\"say \\\"hi\\\"\": \"tab\\tcaf\\u00e9\"}");
+static_assert(staticEscapes.get("say \"hi\"").getString() == "tab\tcaf\xc3\xa9", "static json strings should be decoded at compile time");
+
+TEST(staticJson, escapesMatchFrozen) {
+	SimpleJson testJson = SimpleJson("{\"say \\\"hi\\\"\": \"tab\\tcaf\\u00e9\"}");
+	shared_ptr<const FrozenJson> frozen = testJson.freeze();
+	EXPECT_EQ(frozen->get("say \"hi\"").getString(), staticEscapes.get("say \"hi\"").getString());
+	StaticJsonView root = staticEscapes.root();
+	EXPECT_EQ("tab\tcaf\xc3\xa9", root.get("say \"hi\"").getString());
+}
+
+TEST(staticJson, parserThrowsIfInvalid) {
+	EXPECT_THROW({
+		StaticJsonParser::countElements(invalidExample);
+	}, invalid_argument);
+	EXPECT_THROW({
+		StaticJsonParser::countElements("{\"age\": 027}");
+	}, invalid_argument);
+}
+
+TEST(memory, memoryUsageReportsCategories) {
+	CountingResource resource;
+	JsonOptions options;
+	options.memoryResource = &resource;
+	SimpleJson testJson = SimpleJson(validArrayExample, options);
+	JsonMemoryUsage usage = testJson.memoryUsage();
+	EXPECT_EQ(sizeof(SimpleJson), usage.document);
+	EXPECT_EQ(0, usage.strings);	//every key and value fits inline
+	EXPECT_EQ(0, usage.proxies);
+	EXPECT_LT(0, usage.retainedStrings);
+	size_t parsedBytes = resource.outstandingBytes;
+	testJson.key("drives").setString("no");	//fits inline, so only the proxy is allocated
+	EXPECT_EQ(resource.outstandingBytes - parsedBytes, testJson.memoryUsage().proxies);
+	testJson.key("drives").setString(string(40, 'x'));	//a 64 byte heap block behind the resource pointer
+	EXPECT_EQ(sizeof(pmr::memory_resource*) + 64, testJson.memoryUsage().strings);
+	testJson.compact();
+	usage = testJson.memoryUsage();
+	EXPECT_EQ(7 * sizeof(Element), usage.elements);	//the root, name, skills and its 3 items, and drives
+	EXPECT_EQ(sizeof(pmr::memory_resource*) + 64, usage.strings);
+	EXPECT_EQ(0, usage.elementIndex);
+	EXPECT_EQ(0, usage.proxies);
+	EXPECT_EQ(0, usage.retainedStrings);
+	EXPECT_EQ(resource.outstandingBytes, usage.elements + usage.strings);
+}
+
+TEST(memory, compactKeepsContents) {
+	SimpleJson testJson = SimpleJson(validArrayExample);
+	testJson.key("skills").key(1).setString("coding");
+	string expected = testJson.serialize();
+	size_t before = testJson.memoryUsage().total();
+	testJson.compact();
+	JsonMemoryUsage usage = testJson.memoryUsage();
+	EXPECT_EQ(0, usage.proxies);
+	EXPECT_EQ(0, usage.retainedStrings);
+	EXPECT_EQ(0, usage.elementIndex);
+	EXPECT_GT(before, usage.total());
+	EXPECT_EQ(expected, testJson.serialize());
+	EXPECT_EQ("coding", testJson.get("skills").get(1).getString());
+}
+
+TEST(memory, setAfterCompact) {
+	SimpleJson testJson = SimpleJson(validExampleBasic);
+	testJson.compact();
+	testJson.key("city").setString("london");
+	testJson.compact();
+	EXPECT_EQ("london", testJson.get("city").getString());
+	EXPECT_EQ(27, testJson.get("age").getFloat());
+}
+
+TEST(reset, reparseReplacesDocument) {
+	SimpleJson testJson = SimpleJson(validExample);
+	testJson.key("person").key("name").setString("bob");
+	testJson.reparse(validArrayExample);
+	string input = validArrayExample;
+	removeWhitespace(input);
+	string output = testJson.serialize();
+	removeWhitespace(output);
+	EXPECT_EQ(input, output);
+	EXPECT_EQ("drawing", testJson.get("skills").get(1).getString());
+}
+
+TEST(reset, reparseReusesStorage) {
+	CountingResource resource;
+	JsonOptions options;
+	options.memoryResource = &resource;
+	SimpleJson testJson = SimpleJson(validExample, options);
+	testJson.reparse(validExample);	//the first reparse grows the list of spare elements
+	size_t allocations = resource.allocations;
+	testJson.reparse("{\"person\": {\"name\": \"bob\", \"skills\": false, \"age\": 45}}");
+	EXPECT_EQ(allocations, resource.allocations);
+	EXPECT_EQ(45, testJson.get("person").get("age").getFloat());
+}
+
+TEST(reset, resetLeavesNull) {
+	SimpleJson testJson = SimpleJson(validExample);
+	testJson.reset();
+	EXPECT_EQ("null", testJson.serialize());
+	EXPECT_TRUE(testJson.view().isNull());
+	EXPECT_THROW(testJson.get("person"), invalid_argument);
+	testJson.compact();
+	EXPECT_THROW(testJson.reparse(invalidExample), invalid_argument);
+	EXPECT_EQ("null", testJson.serialize());
+	testJson.reparse(validExampleBasic);
+	EXPECT_EQ("charlie", testJson.get("name").getString());
+}
+
+TEST(reset, reparseAfterCompact) {
+	SimpleJson testJson = SimpleJson(validExample);
+	testJson.compact();
+	testJson.reparse(validExampleBasic);
+	EXPECT_EQ("charlie", testJson.get("name").getString());
+}
+
+TEST(freeze, frozenValuesMatch) {
+	SimpleJson testJson = SimpleJson(validArrayExample);
+	shared_ptr<const FrozenJson> frozen = testJson.freeze();
+	EXPECT_EQ("charlie", frozen->get("name").getString());
+	EXPECT_EQ(5, frozen->get("skills").get(0).getFloat());
+	EXPECT_EQ("drawing", frozen->get("skills").get(1).getString());
+	EXPECT_EQ(false, frozen->get("skills").get(2).getBool());
+	EXPECT_EQ(3, frozen->get("skills").size());
+}
+
+TEST(freeze, frozenIsIndependentOfSource) {
+	shared_ptr<const FrozenJson> frozen;
+	{
+		SimpleJson testJson = SimpleJson(validExampleBasic);
+		frozen = testJson.freeze();
+		testJson.key("name").setString("bob");
+	}
+	EXPECT_EQ("charlie", frozen->get("name").getString());
+}
+
+TEST(freeze, emptyContainersHaveNoChildren) {
+	SimpleJson testJson = SimpleJson("{\"a\": {}, \"b\": [], \"c\": [1]}");
+	shared_ptr<const FrozenJson> frozen = testJson.freeze();
+	EXPECT_EQ(0, frozen->get("a").size());
+	EXPECT_EQ(0, frozen->get("b").size());
+	EXPECT_EQ(1, frozen->get("c").size());
+	EXPECT_THROW(frozen->get("b").get(0), invalid_argument);
+	shared_ptr<const FrozenJson> frozenArray = SimpleJson("[]").freeze();
+	EXPECT_EQ(0, frozenArray->root().size());
+	EXPECT_THROW(frozenArray->get(0), invalid_argument);
+}
+
+TEST(freeze, holderSwapsWhileReading) {
+	FrozenJsonHolder holder(SimpleJson(validExampleBasic).freeze());
+	vector<thread> readers;
+	for (int i = 0; i < 4; i++) {
+		readers.emplace_back([&holder]() {
+			for (int j = 0; j < 1000; j++) {
+				shared_ptr<const FrozenJson> snapshot = holder.load();
+				float age = snapshot->get("age").getFloat();
+				EXPECT_TRUE(age == 27 || age == 45);
+			}
+		});
+	}
+	holder.store(SimpleJson("{\"name\": \"bob\", \"age\": 45}").freeze());
+	for (thread& reader:readers)
+		reader.join();
+	EXPECT_EQ("bob", holder.load()->get("name").getString());
+}
+
+TEST(internKeys, getAndSetByKey) {
+	JsonOptions options;
+	options.internKeys = true;
+	SimpleJson testJson = SimpleJson(validExample, options);
+	EXPECT_EQ("charlie", testJson.get("person").get("name").getString());
+	testJson.key("person").key("age").setFloat(28);
+	testJson.key("person").key("city").setString("london");
+	EXPECT_EQ(28, testJson.get("person").get("age").getFloat());
+	EXPECT_EQ("london", testJson.get("person").get("city").getString());
+	EXPECT_THROW({
+		testJson.get("person").get("town");
+	}, invalid_argument);
+}
+
+TEST(internKeys, serializeOutputMatches) {
+	JsonOptions options;
+	options.internKeys = true;
+	ifstream inputStream("./../examples/large-valid.json");
+	SimpleJson fileJson(inputStream, options);
+	ifstream compareStream("./../examples/large-valid.json");
+	std::stringstream buffer;
+	buffer << compareStream.rdbuf();
+	string input = buffer.str();
+	removeWhitespace(input);
+	string output = fileJson.serialize();
+	removeWhitespace(output);
+	EXPECT_EQ(input, output);
+}
+
+TEST(internKeys, repeatedKeysStoredOnce) {
+	string records = "[{\"a_long_record_key_name\": 1}, {\"a_long_record_key_name\": 2}, {\"a_long_record_key_name\": 3}]";
+	JsonOptions options;
+	options.internKeys = true;
+	SimpleJson interned = SimpleJson(records, options);
+	SimpleJson copied = SimpleJson(records);
+	EXPECT_EQ(0, interned.memoryUsage().strings);
+	EXPECT_LT(0, interned.memoryUsage().internedKeys);
+	EXPECT_LT(0, copied.memoryUsage().strings);
+	EXPECT_EQ(2, interned.get(1).get("a_long_record_key_name").getFloat());
+}
+
+TEST(internKeys, reparseDoesNotGrowPool) {
+	JsonOptions options;
+	options.internKeys = true;
+	SimpleJson testJson = SimpleJson("{\"id0\": 0}", options);
+	size_t poolBytes = 0;
+	for (int i = 1; i <= 100; i++) {
+		testJson.reparse("{\"id" + to_string(i) + "\": " + to_string(i) + "}");
+		if (i == 10) poolBytes = testJson.memoryUsage().internedKeys;
+	}
+	EXPECT_EQ(poolBytes, testJson.memoryUsage().internedKeys);
+	EXPECT_EQ(100, testJson.get("id100").getFloat());
+}
+
+TEST(internKeys, sharedPoolKeptOnReparse) {
+	JsonOptions options;
+	options.internKeys = true;
+	SimpleJson testJson = SimpleJson(validExample, options);
+	SimpleJson person = testJson.get("person");
+	testJson.reparse(validExampleBasic);
+	EXPECT_EQ("charlie", person.get("name").getString());
+	EXPECT_EQ(27, testJson.get("age").getFloat());
+}
+
+TEST(compactElement, fitsInCacheLine) {
+	EXPECT_EQ(16, sizeof(CompactString));
+	EXPECT_LE(sizeof(Element), 64);
+}
+
+TEST(compactElement, shortStringsStoredInline) {
+	SimpleJson testJson = SimpleJson("{\"name\": \"charlie\", \"remote\": true, \"age\": 27, \"fifteen_chars__\": \"\"}");
+	EXPECT_EQ(0, testJson.memoryUsage().strings);
+	EXPECT_EQ("charlie", testJson.get("name").getString());
+	EXPECT_EQ(true, testJson.get("remote").getBool());
+	EXPECT_EQ(27, testJson.get("age").getFloat());
+	EXPECT_EQ("", testJson.get("fifteen_chars__").getString());
+}
+
+TEST(compactElement, longStringsRoundTrip) {
+	string longValue = "a value that is much too long to be stored inline";
+	string longKey = "a_key_that_is_too_long_to_be_inline";
+	SimpleJson testJson = SimpleJson("{\"" + longKey + "\": \"" + longValue + "\"}");
+	EXPECT_LT(0, testJson.memoryUsage().strings);
+	EXPECT_EQ(longValue, testJson.get(longKey).getString());
+	testJson.key(longKey).setString("short");
+	EXPECT_EQ("short", testJson.get(longKey).getString());
+	testJson.key(longKey).setString(longValue + longValue);
+	EXPECT_EQ(longValue + longValue, testJson.get(longKey).getString());
+	EXPECT_EQ("{\"" + longKey + "\": \"" + longValue + longValue + "\"}", testJson.serialize());
+}
+
+TEST(compactElement, rejectsStringsOverSizeLimit) {
+	string text = "a string pointed at but never read";
+	CompactString external;
+	EXPECT_THROW(external.assignExternal(string_view(text.data(), CompactString::MAX_SIZE + 1)), invalid_argument);
+	EXPECT_EQ("", external.view());
+}
+
+TEST(escapes, parseEscapedStrings) {
+	SimpleJson testJson = SimpleJson("{\"quote\": \"say \\\"hi\\\", {ok}\", \"path\": \"C:\\\\temp\\/x\", \"lines\": \"a\\nb\\tc\", \"key \\\"1\\\"\": 1}");
+	EXPECT_EQ("say \"hi\", {ok}", testJson.get("quote").getString());
+	EXPECT_EQ("C:\\temp/x", testJson.get("path").getString());
+	EXPECT_EQ("a\nb\tc", testJson.get("lines").getString());
+	EXPECT_EQ(1, testJson.get("key \"1\"").getFloat());
+}
+
+TEST(escapes, parseUnicodeEscapes) {
+	SimpleJson testJson = SimpleJson("[\"\\u00e9\", \"\\u20AC\", \"\\ud83d\\ude00\", \"\\ud800\"]");
+	EXPECT_EQ("\xC3\xA9", testJson.get(0).getString());
+	EXPECT_EQ("\xE2\x82\xAC", testJson.get(1).getString());
+	EXPECT_EQ("\xF0\x9F\x98\x80", testJson.get(2).getString());
+	EXPECT_EQ("\xEF\xBF\xBD", testJson.get(3).getString());
+	EXPECT_THROW({
+		SimpleJson("[\"\\x\"]");
+	}, invalid_argument);
+	EXPECT_THROW({
+		SimpleJson("[\"\\u12G4\"]");
+	}, invalid_argument);
+}
+
+TEST(escapes, serializeEscapesStrings) {
+	string input = "{\"quote\": \"say \\\"hi\\\"\", \"control\": \"tab\\there\\u0001\", \"long\": \"a long string with a \\\\ backslash past the first sixteen bytes\"}";
+	SimpleJson testJson = SimpleJson(input);
+	EXPECT_EQ(input, testJson.serialize());
+	testJson.key("quote").setString("\"quoted\"\n");
+	EXPECT_EQ("\"quoted\"\n", testJson.get("quote").getString());
+	EXPECT_EQ("\"\\\"quoted\\\"\\n\"", testJson.get("quote").serialize());
+}
+
+TEST(escapes, mappingDecodesEscapes) {
+	Person person = JsonMapper::parse<Person>("{\"name\": \"char\\\"lie\\u00e9\", \"age\": 27, \"remote\": true, \"skills\": [{\"name\": \"a\\\\b\", \"level\": 1}]}");
+	EXPECT_EQ("char\"lie\xC3\xA9", person.name);
+	EXPECT_EQ("a\\b", person.skills[0].name);
+	EXPECT_EQ(person.name, JsonMapper::parse<Person>(JsonMapper::serialize(person)).name);
+}
+
+TEST(utf8, validatesSequences) {
+	EXPECT_TRUE(isValidUtf8(""));
+	EXPECT_TRUE(isValidUtf8("caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80 \xF4\x8F\xBF\xBF"));
+	EXPECT_FALSE(isValidUtf8("\xC0\x80"));			//overlong
+	EXPECT_FALSE(isValidUtf8("\xE0\x9F\xBF"));		//overlong
+	EXPECT_FALSE(isValidUtf8("\xED\xA0\x80"));		//surrogate
+	EXPECT_FALSE(isValidUtf8("\xF4\x90\x80\x80"));	//above U+10FFFF
+	EXPECT_FALSE(isValidUtf8("\x80"));				//lone continuation byte
+	EXPECT_FALSE(isValidUtf8("\xE2\x82"));			//truncated
+	EXPECT_FALSE(isValidUtf8("\xFF"));
+}
+
+TEST(utf8, validatesEveryPosition) {
+	//move the bad byte through the vector blocks and the scalar tail
+	for (size_t length = 1; length < 100; length++) {
+		for (size_t bad = 0; bad < length; bad++) {
+			string text(length, 'a');
+			EXPECT_TRUE(isValidUtf8(text));
+			text[bad] = '\xFF';
+			EXPECT_FALSE(isValidUtf8(text)) << length << " " << bad;
+		}
+	}
+}
+
+TEST(utf8, parseOption) {
+	string invalid = "{\"name\": \"char\xFFlie\", \"age\": 27}";
+	string valid = "{\"name\": \"caf\xC3\xA9 \\\"quoted\\\"\", \"age\": 27}";
+	JsonOptions options;
+	options.validateUtf8 = true;
+	EXPECT_EQ("char\xFFlie", SimpleJson(invalid).get("name").getString());
+	EXPECT_THROW({
+		SimpleJson(invalid, options);
+	}, invalid_argument);
+	SimpleJson testJson = SimpleJson(valid, options);
+	EXPECT_EQ("caf\xC3\xA9 \"quoted\"", testJson.get("name").getString());
+	EXPECT_THROW({
+		testJson.reparse(invalid);
+	}, invalid_argument);
+}
+
+TEST(views, rangeForOverItemsAndMembers) {
+	SimpleJson testJson = SimpleJson(mappingExample);
+	vector<string> keys;
+	for (auto [key, value] : testJson.members()) keys.push_back(string(key));
+	EXPECT_EQ(vector<string>({"name", "age", "remote", "skills"}), keys);
+	float total = 0;
+	for (JsonView skill : testJson.view().get("skills").items()) total += skill.get("level").getFloat();
+	EXPECT_EQ(6.5, total);
+	EXPECT_EQ("coding", testJson.view().get("skills").get(1).get("name").getString());
+	EXPECT_EQ(2, testJson.view().get("skills").size());
+}
+
+TEST(views, worksWithAlgorithms) {
+	SimpleJson testJson = SimpleJson("[3, \"a\", 7, null, 12]");
+	auto items = testJson.items();
+	EXPECT_EQ(5, distance(items.begin(), items.end()));
+	EXPECT_EQ(3, count_if(items.begin(), items.end(), [](JsonView item) { return item.isFloat(); }));
+	auto found = find_if(items.begin(), items.end(), [](JsonView item) { return item.isFloat() && item.getFloat() > 5; });
+	EXPECT_EQ(7, (*found).getFloat());
+	EXPECT_TRUE(testJson.view().get(3).isNull());
+}
+
+TEST(views, emptyContainersAndErrors) {
+	SimpleJson testJson = SimpleJson("{\"list\": [], \"object\": {}, \"value\": true}");
+	EXPECT_TRUE(testJson.view().get("list").items().empty());
+	EXPECT_TRUE(testJson.view().get("object").members().empty());
+	EXPECT_EQ(0, testJson.view().get("list").size());
+	EXPECT_THROW({
+		testJson.view().get("value").items();
+	}, invalid_argument);
+	EXPECT_THROW({
+		testJson.view().get("missing");
+	}, invalid_argument);
+	EXPECT_THROW({
+		testJson.view().get("list").members();
+	}, invalid_argument);
+}
+
+TEST(asyncLoad, loadsFilesInBackground) {
+	vector<string> paths = {"./../examples/small-valid.json", "./../examples/medium-valid.json", "./../examples/large-valid.json", "./../examples/large-valid-2.json"};
+	JsonFileLoader loader(JsonOptions(), 64, 256);	//small blocks and queue so reads are split and the reader has to wait
+	vector<future<unique_ptr<SimpleJson>>> results;
+	for (const string& path : paths) results.push_back(loader.load(path));
+	for (size_t i = 0; i < paths.size(); i++) {
+		ifstream stream(paths[i]);
+		SimpleJson expected(stream);
+		EXPECT_EQ(expected.serialize(), results[i].get()->serialize());
+	}
+}
+
+TEST(asyncLoad, reportsErrorsThroughFuture) {
+	JsonFileLoader loader;
+	future<unique_ptr<SimpleJson>> invalid = loader.load("./../examples/medium-invalid.json");
+	future<unique_ptr<SimpleJson>> missing = loader.load("./../examples/missing.json");
+	future<unique_ptr<SimpleJson>> valid = loader.load("./../examples/small-valid.json");
+	EXPECT_THROW({
+		invalid.get();
+	}, invalid_argument);
+	EXPECT_THROW({
+		missing.get();
+	}, invalid_argument);
+	EXPECT_NE(nullptr, valid.get());
+}
+
+TEST(hashing, equalityIgnoresMemberOrder) {
+	JsonOptions options;
+	options.hashSubtrees = true;
+	SimpleJson first = SimpleJson("{\"a\": 1, \"b\": [1, 2], \"c\": {\"d\": \"x\", \"e\": null}}", options);
+	SimpleJson reordered = SimpleJson("{\"c\": {\"e\": null, \"d\": \"x\"}, \"b\": [1, 2], \"a\": 1}", options);
+	SimpleJson swappedItems = SimpleJson("{\"a\": 1, \"b\": [2, 1], \"c\": {\"d\": \"x\", \"e\": null}}", options);
+	SimpleJson changed = SimpleJson("{\"a\": 1, \"b\": [1, 2], \"c\": {\"d\": \"y\", \"e\": null}}", options);
+	EXPECT_TRUE(first.equals(reordered));
+	EXPECT_FALSE(first.equals(swappedItems));
+	EXPECT_FALSE(first.equals(changed));
+	EXPECT_EQ(first.get("c").hash(), reordered.get("c").hash());
+	EXPECT_THROW({
+		SimpleJson(validExample).hash();
+	}, invalid_argument);
+}
+
+TEST(hashing, setKeepsHashesUpToDate) {
+	JsonOptions options;
+	options.hashSubtrees = true;
+	SimpleJson testJson = SimpleJson(mappingExample, options);
+	testJson.key("skills").key(1).key("name").setString("painting");
+	testJson.key("remote").setBool(false);
+	testJson.key("city").setString("london");
+	testJson.key("skills").key(1).key("level").setString("high");
+	SimpleJson expected = SimpleJson(testJson.serialize(), options);
+	EXPECT_EQ(expected.hash(), testJson.hash());
+	EXPECT_EQ(expected.get("skills").hash(), testJson.get("skills").hash());
+	SimpleJson array = SimpleJson(validArrayExampleBasic, options);
+	array.key(4).setString("appended");
+	EXPECT_EQ(SimpleJson(array.serialize(), options).hash(), array.hash());
+}
+
+TEST(hashing, setOnEmptyContainersMatchesParse) {
+	JsonOptions options;
+	options.hashSubtrees = true;
+	SimpleJson testJson = SimpleJson("{\"person\": {}, \"skills\": [], \"tags\": []}", options);
+	testJson.key("person").key("name").setString("charlie");
+	testJson.key("skills").key(0).setString("drawing");
+	testJson.key("tags").key(1).setBool(true);
+	SimpleJson expected = SimpleJson("{\"person\": {\"name\": \"charlie\"}, \"skills\": [\"drawing\"], \"tags\": [null, true]}", options);
+	EXPECT_EQ(expected.serialize(), testJson.serialize());
+	EXPECT_TRUE(testJson.equals(expected));
+	EXPECT_TRUE(testJson.diff(expected).empty());
+	SimpleJson array = SimpleJson("[]", options);
+	array.key(2).setFloat(1);
+	EXPECT_EQ(SimpleJson(array.serialize(), options).hash(), array.hash());
+}
+
+TEST(hashing, numbersCompareAsText) {
+	JsonOptions options;
+	options.hashSubtrees = true;
+	SimpleJson integer = SimpleJson("[1]", options);
+	SimpleJson decimal = SimpleJson("[1.0]", options);
+	EXPECT_FALSE(integer.equals(decimal));
+}
+
+TEST(hashing, diffReportsChangedPaths) {
+	JsonOptions options;
+	options.hashSubtrees = true;
+	SimpleJson before = SimpleJson("{\"name\": \"charlie\", \"a/b\": 1, \"skills\": [\"drawing\", \"coding\"], \"address\": {\"city\": \"london\"}, \"old\": true}", options);
+	SimpleJson after = SimpleJson("{\"name\": \"charlie\", \"a/b\": 2, \"skills\": [\"drawing\", \"chess\", \"go\"], \"address\": {\"city\": \"london\"}, \"new\": true}", options);
+	EXPECT_EQ(vector<string>({"/a~1b", "/skills/1", "/skills/2", "/old", "/new"}), before.diff(after));
+	EXPECT_TRUE(before.diff(before).empty());
+}
+
+TEST(canonical, sortsKeysAndRemovesWhitespace) {
+	SimpleJson first = SimpleJson("{\"b\": [3, {\"z\": null, \"a\": true}], \"a\": \"x\\ny\", \"c\": {}, \"d\": []}");
+	SimpleJson second = SimpleJson("{\"d\": [], \"c\": {}, \"a\": \"x\\ny\", \"b\": [3, {\"a\": true, \"z\": null}]}");
+	EXPECT_EQ("{\"a\":\"x\\ny\",\"b\":[3,{\"a\":true,\"z\":null}],\"c\":{},\"d\":[]}", first.serializeCanonical());
+	EXPECT_EQ(first.serializeCanonical(), second.serializeCanonical());
+	EXPECT_EQ("\"x\\ny\"", first.get("a").serializeCanonical());
+}
+
+TEST(canonical, formatsNumbers) {
+	SimpleJson testJson = SimpleJson("[0, -0, 1, 2.50, 100, 1e21, 1e20, 123456789012345680000, 1e-6, 1e-7, 0.000001234, -1.5e-10, 333333333.33333329, 4.50, 2e-3]");
+	EXPECT_EQ("[0,0,1,2.5,100,1e+21,100000000000000000000,123456789012345680000,0.000001,1e-7,0.000001234,-1.5e-10,333333333.3333333,4.5,0.002]", testJson.serializeCanonical());
+	testJson.key(0).setFloat(28);
+	EXPECT_EQ("28", testJson.get(0).serializeCanonical());
+}
+
+TEST(canonical, sortsKeysByUtf16) {
+	//the ordering example from RFC 8785 section 3.2.3
+	SimpleJson testJson = SimpleJson("{\"\\u20ac\": \"Euro Sign\", \"\\r\": \"Carriage Return\", \"\\ufb33\": \"Hebrew Letter Dalet With Dagesh\", \"1\": \"One\", \"\\ud83d\\ude00\": \"Emoji: Grinning Face\", \"\\u0080\": \"Control\", \"\\u00f6\": \"Latin Small Letter O With Diaeresis\"}");
+	string expected = "{\"\\r\":\"Carriage Return\",\"1\":\"One\",\"\xC2\x80\":\"Control\",\"\xC3\xB6\":\"Latin Small Letter O With Diaeresis\",\"\xE2\x82\xAC\":\"Euro Sign\",\"\xF0\x9F\x98\x80\":\"Emoji: Grinning Face\",\"\xEF\xAC\xB3\":\"Hebrew Letter Dalet With Dagesh\"}";
+	EXPECT_EQ(expected, testJson.serializeCanonical());
+}
+
+TEST(bulk, toVectorConvertsItems) {
+	SimpleJson numbers = SimpleJson("[1, -2.5, 3e2, 12345678901234567, 0.1]");
+	EXPECT_EQ(vector<double>({1, -2.5, 300, 12345678901234567.0, 0.1}), numbers.toVector<double>());
+	EXPECT_EQ(vector<int64_t>({1, -2, 3}), SimpleJson("[1, -2, 3]").toVector<int64_t>());
+	EXPECT_EQ(vector<bool>({true, false}), SimpleJson("[true, false]").toVector<bool>());
+	SimpleJson strings = SimpleJson("[\"a\", \"b\\\"c\"]");
+	EXPECT_EQ(vector<string_view>({"a", "b\"c"}), strings.toVector<string_view>());
+	EXPECT_TRUE(SimpleJson("{\"list\": []}").view().get("list").toVector<double>().empty());
+	EXPECT_THROW({
+		numbers.toVector<int64_t>();
+	}, invalid_argument);
+	EXPECT_THROW({
+		strings.toVector<double>();
+	}, invalid_argument);
+	EXPECT_THROW({
+		SimpleJson("[300]").toVector<uint8_t>();
+	}, invalid_argument);
+}
+
+TEST(bulk, copyToCallerBuffer) {
+	SimpleJson testJson = SimpleJson("{\"values\": [4, 5, 6]}");
+	float buffer[4] = {0, 0, 0, 0};
+	EXPECT_EQ(3, testJson.view().get("values").copyTo(buffer, 4));
+	EXPECT_EQ(5, buffer[1]);
+	EXPECT_THROW({
+		testJson.view().get("values").copyTo(buffer, 2);
+	}, invalid_argument);
+}
+
+TEST(bulk, parseNumbersWithoutTree) {
+	EXPECT_EQ(vector<double>({1.5, -0.001, 1e300, 123456.789, 9007199254740993.0, 2}), JsonMapper::parse<vector<double>>("[1.5, -0.001, 1e300, 123456.789, 9007199254740993, 2]"));
+	EXPECT_EQ(vector<int64_t>({12345678901, -9223372036854775807 - 1, 0}), JsonMapper::parse<vector<int64_t>>("[12345678901, -9223372036854775808, 0]"));
+	for (string number : {"0.1", "3.14159265358979", "2.2250738585072014e-308", "1e23", "7.5e-10", "123456789012345678"}) {
+		double parsed = 0;
+		EXPECT_TRUE(parseJsonNumber(number, parsed));
+		EXPECT_EQ(stod(number), parsed) << number;
+	}
+	double invalid = 0;
+	EXPECT_FALSE(parseJsonNumber("1.5x", invalid));
+	EXPECT_FALSE(parseJsonNumber("1e", invalid));
+	for (string number : {"01", "-01", "1.", "1.e5", ".5", "-.5", "-", "inf", "nan"}) {
+		EXPECT_FALSE(parseJsonNumber(number, invalid)) << number;
+	}
+	int64_t integer = 0;
+	EXPECT_FALSE(parseJsonNumber("007", integer));
+	EXPECT_THROW({
+		JsonMapper::parse<vector<double>>("[1, 01]");
+	}, invalid_argument);
+	EXPECT_THROW({
+		JsonMapper::parse<vector<double>>("[.5]");
+	}, invalid_argument);
+	EXPECT_THROW({
+		JsonMapper::parse<vector<double>>("[1.]");
+	}, invalid_argument);
+}
+
+TEST(allocator, parsesIntoMonotonicBuffer) {
+	string input = "{\"people\": [{\"name\": \"a name too long to be stored inline\", \"age\": 27}, {\"name\": \"charlie\", \"age\": 31}]}";
+	char buffer[1 << 16];
+	pmr::monotonic_buffer_resource resource(buffer, sizeof(buffer), pmr::null_memory_resource());
+	//anything allocated from the default resource instead of the document's would throw
+	pmr::memory_resource* pPrevious = pmr::set_default_resource(pmr::null_memory_resource());
+	JsonOptions options;
+	options.internKeys = true;
+	options.memoryResource = &resource;
+	{
+		SimpleJson testJson = SimpleJson(input, options);
+		testJson.key("people").key(1).key("city").setString("another string too long to be inline");
+		SimpleJson person = testJson.get("people").get(0);
+		EXPECT_EQ("a name too long to be stored inline", person.get("name").getString());
+		EXPECT_EQ("another string too long to be inline", testJson.get("people").get(1).get("city").getString());
+		testJson.compact();
+		EXPECT_EQ(31, testJson.get("people").get(1).get("age").getFloat());
+	}
+	pmr::set_default_resource(pPrevious);
+}
+
+TEST(allocator, memoryUsageMatchesResource) {
+	CountingResource resource;
+	JsonOptions options;
+	options.memoryResource = &resource;
+	SimpleJson testJson = SimpleJson(mappingExample, options);
+	testJson.key("skills").key(0).key("name").setString("a value long enough to need heap storage");
+	testJson.key("name").setString("bob");
+	JsonMemoryUsage usage = testJson.memoryUsage();
+	EXPECT_LT(0, usage.proxies);
+	EXPECT_EQ(resource.outstandingBytes, usage.total() - usage.document);
+	testJson.compact();
+	usage = testJson.memoryUsage();
+	EXPECT_EQ(resource.outstandingBytes, usage.total() - usage.document);
+}
+
+TEST(allocator, everyAllocationReturnedToResource) {
+	CountingResource resource;
+	JsonOptions options;
+	options.memoryResource = &resource;
+	{
+		SimpleJson testJson = SimpleJson(validArrayExample, options);
+		testJson.key("drives").setString("a value long enough to need heap storage");
+		testJson.reparse(mappingExample);
+		EXPECT_EQ("drawing", testJson.get("skills").get(0).get("name").getString());
+		testJson.compact();
+		EXPECT_LT(0, resource.outstandingBytes);
+	}
+	EXPECT_LT(0, resource.allocations);
+	EXPECT_EQ(0, resource.outstandingBytes);
+}
+
+TEST(writer, writesNestedDocument) {
+	string output;
+	JsonWriter writer(output);
+	writer.beginObject().key("name").value("charlie").key("age").value(27).key("remote").value(true);
+	writer.key("skills").beginArray().value(2.5).value("tab\there").null().endArray();
+	writer.key("empty").beginObject().endObject().endObject();
+	EXPECT_TRUE(writer.isComplete());
+	EXPECT_EQ("{\"name\": \"charlie\", \"age\": 27, \"remote\": true, \"skills\": [2.5, \"tab\\there\", null], \"empty\": {}}", output);
+	SimpleJson parsed = SimpleJson(output);
+	EXPECT_EQ("tab\there", parsed.get("skills").get(1).getString());
+}
+
+TEST(writer, writesShortestFloats) {
+	string output;
+	JsonWriter(output).beginArray().value(0.1f).value(0.1).value(-1.5f).value(1e-7f).value(3.0f).endArray();
+	EXPECT_EQ("[0.1, 0.1, -1.5, 1e-07, 3]", output);
+}
+
+TEST(writer, streamsThroughSmallBuffer) {
+	ostringstream stream;
+	string expected;
+	{
+		JsonWriter writer(stream, 16);
+		JsonWriter direct(expected);
+		writer.beginArray();
+		direct.beginArray();
+		for (int i = 0; i < 100; i++) {
+			writer.beginObject().key("id").value(i).key("score").value(i / 4.0).endObject();
+			direct.beginObject().key("id").value(i).key("score").value(i / 4.0).endObject();
+		}
+		writer.endArray();
+		direct.endArray();
+		EXPECT_LT(0, stream.str().size());	//full buffers were passed on before the end
+	}
+	EXPECT_EQ(expected, stream.str());
+	EXPECT_EQ(99, SimpleJson(expected).get(99).get("id").getFloat());
+}
+
+TEST(writer, throwsOnInvalidStructure) {
+	string output;
+	EXPECT_THROW(JsonWriter(output).value(nan("")), invalid_argument);
+#ifndef NDEBUG
+	EXPECT_THROW(JsonWriter(output).beginArray().key("name"), invalid_argument);
+	EXPECT_THROW(JsonWriter(output).beginObject().value(1), invalid_argument);
+	EXPECT_THROW(JsonWriter(output).beginObject().key("a").key("b"), invalid_argument);
+	EXPECT_THROW(JsonWriter(output).beginArray().endObject(), invalid_argument);
+	EXPECT_THROW(JsonWriter(output).beginObject().key("a").endObject(), invalid_argument);
+	EXPECT_THROW(JsonWriter(output).value(1).value(2), invalid_argument);
+	JsonWriter writer(output);
+	writer.beginArray();
+	EXPECT_FALSE(writer.isComplete());
+#endif
+}
+
 int main(int argc, char** argv) {
 	::testing::InitGoogleTest(&argc, argv);
 	RUN_ALL_TESTS();